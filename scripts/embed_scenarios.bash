@@ -0,0 +1,86 @@
+#!/usr/bin/env bash
+#
+# Turn scenario files into a header of constexpr scenarios, so the simulation
+# can be specialized for them at compile time (see src/scenario_engine.hpp).
+#
+# Usage:
+#  embed_scenarios.bash [-o scenarios.hpp] FILE...
+
+declare target_file="scenarios.hpp"
+declare -a scenario_files=()
+
+set -e
+
+function err() {
+  if [[ -t 2 ]]; then
+    echo "$(tput setaf 1)$(tput bold)${*}$(tput sgr0)" >&2
+  else
+    echo "$@" >&2
+  fi
+  exit 1
+}
+
+while (( $# > 0 )); do
+  case "$1" in
+    -o)
+      if [[ -z "$2" ]]; then
+        err "Missing parameter for '-o'"
+      fi
+      target_file="$2"
+      shift
+      ;;
+    -*)
+      err "Unhandled option '$1'"
+      ;;
+    *)
+      scenario_files+=("$1")
+      ;;
+  esac
+  shift
+done
+
+declare -a names=()
+temp_file="$(mktemp)"
+trap 'rm -f "$temp_file"' EXIT
+
+{
+  echo "// Generated by scripts/embed_scenarios.bash, do not edit"
+  echo "#pragma once"
+  echo
+  echo "#include \"scenario.hpp\""
+  echo
+  echo "namespace scenarios {"
+  for file in "${scenario_files[@]}"; do
+    [[ -f "$file" ]] || err "File not found: $file"
+    name="$(basename "$file" .txt)"
+    name="${name//[^a-zA-Z0-9_]/_}"
+    names+=("$name")
+
+    # First line: x y h_speed v_speed fuel rotate power, then the ground line
+    read -r x y vx vy fuel rotate power < "$file"
+    points="$(tail -n +2 "$file" | tr -d '\r' |
+              awk 'NF == 2 { printf "    {%s, %s},\n", $1, $2 }')"
+    count="$(grep -c '{' <<< "$points")"
+    (( count > 1 )) || err "No ground line in $file"
+
+    echo "constexpr inline scenario<${count}> ${name}{"
+    echo "  .name = \"${name}\","
+    echo "  .initial = {"
+    echo "    .position = {${x}, ${y}},"
+    echo "    .velocity = {${vx}, ${vy}},"
+    echo "    .fuel = ${fuel},"
+    echo "    .rotate = ${rotate},"
+    echo "    .power = ${power},"
+    echo "  },"
+    echo "  .ground_line = {{"
+    echo "${points}"
+    echo "  }},"
+    echo "};"
+    echo
+  done
+  echo "using embedded = scenario_list<$(IFS=,; echo "${names[*]}" | sed 's/,/, /g')>;"
+  echo "} // namespace scenarios"
+} > "$temp_file"
+
+mv "$temp_file" "$target_file"
+trap - EXIT
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "constants.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace detail {
+// std::sin and std::cos aren't constexpr, the angles we need are within
+// [-pi/2, pi/2] where the Taylor series converges quickly.
+constexpr double taylor_series(double x, double term, int first_power) {
+  double sum = 0;
+  for (int n = first_power; n < 40; n += 2) {
+    sum += term;
+    term *= -x * x / ((n + 1) * (n + 2));
+  }
+  return sum;
+}
+constexpr double sin(double x) { return taylor_series(x, x, 1); }
+constexpr double cos(double x) { return taylor_series(x, 1., 0); }
+} // namespace detail
+
+/// Velocity change over one tick for every (rotate, power) pair the lander can
+/// be in, gravity included.
+struct acceleration_table {
+  constexpr static inline int ROTATIONS = 2 * MAX_ROTATION + 1;
+  constexpr static inline int POWERS = MAX_POWER + 1;
+  constexpr static inline int SIZE = ROTATIONS * POWERS;
+
+  std::array<double, SIZE> x;
+  std::array<double, SIZE> y;
+
+  [[nodiscard]] constexpr static int index(int rotate, int power) {
+    return (rotate + MAX_ROTATION) * POWERS + power;
+  }
+
+  constexpr acceleration_table() : x{}, y{} {
+    for (int rotate = -MAX_ROTATION; rotate <= MAX_ROTATION; ++rotate) {
+      for (int power = 0; power <= MAX_POWER; ++power) {
+        x[index(rotate, power)] = power * -detail::sin(rotate * DEG_TO_RAD);
+        y[index(rotate, power)] =
+            power * detail::cos(rotate * DEG_TO_RAD) - MARS_GRAVITY;
+      }
+    }
+  }
+};
+
+constexpr static inline acceleration_table ACCELERATION{};
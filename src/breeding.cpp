@@ -0,0 +1,188 @@
+#include "breeding.hpp"
+#include "cpu_dispatch.hpp"
+#include "tracy_shim.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+namespace {
+// Four genes make one SSE2 register of eight 16 bit lanes, the rotation and
+// the power of a gene go through the same instructions
+constexpr size_t LANES = 4;
+static_assert(sizeof(gene) == sizeof(std::uint32_t));
+
+#ifdef __SSE2__
+__m128i load(const gene *g) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(g));
+}
+void store(gene *g, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(g), v);
+}
+/// x where mask is clear, y where it is set
+__m128i blend(__m128i mask, __m128i x, __m128i y) {
+  return _mm_or_si128(_mm_andnot_si128(mask, x), _mm_and_si128(mask, y));
+}
+#endif
+
+/// a * w + b * (1 - w) with w a 16 bit fraction, rounded down
+std::uint16_t mix(std::uint16_t a, std::uint16_t b, std::uint16_t w) {
+  const std::uint16_t complement = ~w;
+  return static_cast<std::uint16_t>(((std::uint32_t{a} * w) >> 16) +
+                                    ((std::uint32_t{b} * complement) >> 16));
+}
+
+gene mix(const gene &a, const gene &b, std::uint16_t w) {
+  return {mix(a.rotate, b.rotate, w), mix(a.power, b.power, w)};
+}
+
+/// Length shared by the parents and the children
+size_t length(const_genome p1, const_genome p2, const_genome child1,
+              const_genome child2) {
+  ASSERT(p2.size() == p1.size() && child1.size() == p1.size() &&
+         child2.size() == p1.size());
+  return p1.size();
+}
+
+std::vector<crossover_operator> &registry() {
+  static std::vector<crossover_operator> operators{
+      {"linear interpolation", crossover_linear_interpolation},
+      {"random selection", crossover_random_selection},
+      {"alternate", crossover_alternate},
+  };
+  return operators;
+}
+} // namespace
+
+CPU_DISPATCH
+void crossover_linear_interpolation(const_genome p1, const_genome p2,
+                                    genome child1, genome child2,
+                                    random_stream &random) {
+  ZoneScoped;
+  const auto n = length(p1, p2, child1, child2);
+  size_t i = 0;
+  // One 16 bit weight per gene
+  for (; i + LANES <= n; i += LANES) {
+    const auto bits = random.next();
+#ifdef __SSE2__
+    const auto weights = _mm_set_epi64x(0, static_cast<long long>(bits));
+    const auto w = _mm_unpacklo_epi16(weights, weights);
+    const auto complement = _mm_xor_si128(w, _mm_set1_epi32(-1));
+    const auto a = load(&p1[i]);
+    const auto b = load(&p2[i]);
+    store(&child1[i], _mm_add_epi16(_mm_mulhi_epu16(a, w),
+                                    _mm_mulhi_epu16(b, complement)));
+    store(&child2[i], _mm_add_epi16(_mm_mulhi_epu16(a, complement),
+                                    _mm_mulhi_epu16(b, w)));
+#else
+    for (size_t j = 0; j < LANES; ++j) {
+      const auto w = static_cast<std::uint16_t>(bits >> (16 * j));
+      child1[i + j] = mix(p1[i + j], p2[i + j], w);
+      child2[i + j] = mix(p1[i + j], p2[i + j], static_cast<std::uint16_t>(~w));
+    }
+#endif
+  }
+  for (; i < n; ++i) {
+    const auto w = static_cast<std::uint16_t>(random.next());
+    child1[i] = mix(p1[i], p2[i], w);
+    child2[i] = mix(p1[i], p2[i], static_cast<std::uint16_t>(~w));
+  }
+}
+
+CPU_DISPATCH
+void crossover_random_selection(const_genome p1, const_genome p2,
+                                genome child1, genome child2,
+                                random_stream &random) {
+  ZoneScoped;
+  const auto n = length(p1, p2, child1, child2);
+  // One random bit per gene
+  for (size_t block = 0; block < n; block += 64) {
+    const auto bits = random.next();
+    const auto end = std::min(n, block + 64);
+    size_t i = block;
+#ifdef __SSE2__
+    const auto lanes = _mm_setr_epi32(1, 2, 4, 8);
+    for (; i + LANES <= end; i += LANES) {
+      const auto nibble =
+          _mm_set1_epi32(static_cast<int>((bits >> (i - block)) & 0xf));
+      const auto swap = _mm_cmpeq_epi32(_mm_and_si128(nibble, lanes), lanes);
+      const auto a = load(&p1[i]);
+      const auto b = load(&p2[i]);
+      store(&child1[i], blend(swap, a, b));
+      store(&child2[i], blend(swap, b, a));
+    }
+#endif
+    for (; i < end; ++i) {
+      const bool swap = (bits >> (i - block)) & 1;
+      child1[i] = swap ? p2[i] : p1[i];
+      child2[i] = swap ? p1[i] : p2[i];
+    }
+  }
+}
+
+CPU_DISPATCH
+void crossover_alternate(const_genome p1, const_genome p2, genome child1,
+                         genome child2, random_stream &) {
+  ZoneScoped;
+  const auto n = length(p1, p2, child1, child2);
+  size_t i = 0;
+#ifdef __SSE2__
+  const auto odd = _mm_setr_epi32(0, -1, 0, -1);
+  for (; i + LANES <= n; i += LANES) {
+    const auto a = load(&p1[i]);
+    const auto b = load(&p2[i]);
+    store(&child1[i], blend(odd, a, b));
+    store(&child2[i], blend(odd, b, a));
+  }
+#endif
+  for (; i < n; ++i) {
+    const bool swap = i % 2 == 1;
+    child1[i] = swap ? p2[i] : p1[i];
+    child2[i] = swap ? p1[i] : p2[i];
+  }
+}
+
+// Not cloned, unlike the crossovers: skipping from one mutated gene to the
+// next leaves no loop over the genes to vectorize.
+void mutate(genome p, double mutation_rate, random_stream &random) {
+  ZoneScoped;
+  if (mutation_rate <= 0) {
+    return;
+  }
+  // The rotation and the power of every gene are as many trials. The number
+  // of misses before the next mutation follows a geometric distribution,
+  // drawn by inverting its cumulative distribution.
+  const size_t trials = 2 * p.size();
+  const bool every_trial = mutation_rate >= 1;
+  const auto log_miss = every_trial ? 0. : std::log1p(-mutation_rate);
+  for (size_t trial = 0;; ++trial) {
+    if (!every_trial) {
+      // log1p(-u) is finite and at most 0 for u in [0, 1)
+      const auto misses = std::floor(std::log1p(-random()) / log_miss);
+      if (misses >= static_cast<double>(trials - trial)) {
+        return;
+      }
+      trial += static_cast<size_t>(misses);
+    }
+    if (trial >= trials) {
+      return;
+    }
+    auto &g = p[trial / 2];
+    (trial % 2 == 0 ? g.rotate : g.power) =
+        static_cast<std::uint16_t>(random.next() >> 48);
+  }
+}
+
+std::span<const crossover_operator> crossover_operators() { return registry(); }
+
+size_t register_crossover(crossover_operator op) {
+  ASSERT(op.apply != nullptr);
+  registry().push_back(op);
+  return registry().size() - 1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "individual.hpp"
+#include "random.hpp"
+
+#include <span>
+
+// Genetic operators working on whole genomes at once: the random numbers are
+// drawn in bulk and the 16 bit genes are handled four at a time. The children
+// can't overlap the parents.
+
+/// Each child gene is a random weighted average of the parents' genes, the
+/// second child takes the complementary weights
+void crossover_linear_interpolation(const_genome p1, const_genome p2,
+                                    genome child1, genome child2,
+                                    random_stream &random);
+
+/// Each child gene comes from either parent with even odds, the second child
+/// gets the gene the first one didn't
+void crossover_random_selection(const_genome p1, const_genome p2,
+                                genome child1, genome child2,
+                                random_stream &random);
+
+/// The children take their genes from each parent in turn
+void crossover_alternate(const_genome p1, const_genome p2, genome child1,
+                         genome child2, random_stream &random);
+
+/// What every crossover looks like: two children from two parents, all of
+/// the same length
+using crossover_function = void (*)(const_genome p1, const_genome p2,
+                                    genome child1, genome child2,
+                                    random_stream &random);
+
+struct crossover_operator {
+  const char *name;
+  crossover_function apply;
+};
+
+/// Crossovers the breeding picks from, the three above first
+std::span<const crossover_operator> crossover_operators();
+
+/// Adds a crossover to pick from and returns its index. Not to be called
+/// while a generation is bred, the span above no longer holds after it.
+size_t register_crossover(crossover_operator op);
+
+/// Redraws the rotation and the power of each gene with probability
+/// mutation_rate. Jumps from one mutation to the next so that the cost
+/// follows the number of mutations rather than the number of genes.
+void mutate(genome p, double mutation_rate, random_stream &random);
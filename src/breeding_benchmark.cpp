@@ -0,0 +1,150 @@
+#include "breeding.hpp"
+#include "cpu_dispatch.hpp"
+#include "individual.hpp"
+#include "random.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Compares the genetic operators of breeding.hpp with gene by gene versions
+// drawing from randf inside the loops
+
+namespace scalar {
+void crossover_linear_interpolation(const_genome p1, const_genome p2,
+                                    genome child1, genome child2) {
+  for (size_t i = 0; i < p1.size(); ++i) {
+    auto r = randf();
+    child1[i] = gene::from(r * p1[i].rotation() + (1 - r) * p2[i].rotation(),
+                           r * p1[i].thrust() + (1 - r) * p2[i].thrust());
+    child2[i] = gene::from((1 - r) * p1[i].rotation() + r * p2[i].rotation(),
+                           (1 - r) * p1[i].thrust() + r * p2[i].thrust());
+  }
+}
+
+void crossover_random_selection(const_genome p1, const_genome p2,
+                                genome child1, genome child2) {
+  for (size_t i = 0; i < p1.size(); ++i) {
+    if (randf() < .5) {
+      child1[i] = p1[i];
+      child2[i] = p2[i];
+    } else {
+      child1[i] = p2[i];
+      child2[i] = p1[i];
+    }
+  }
+}
+
+void crossover_alternate(const_genome p1, const_genome p2, genome child1,
+                         genome child2) {
+  for (size_t i = 0; i < p1.size(); ++i) {
+    if (i % 2 == 0) {
+      child1[i] = p1[i];
+      child2[i] = p2[i];
+    } else {
+      child1[i] = p2[i];
+      child2[i] = p1[i];
+    }
+  }
+}
+
+void mutate(genome p, double mutation_rate) {
+  for (auto &g : p) {
+    if (randf() < mutation_rate) {
+      g.rotate = gene::quantize(randf());
+    }
+    if (randf() < mutation_rate) {
+      g.power = gene::quantize(randf());
+    }
+  }
+}
+} // namespace scalar
+
+namespace {
+constexpr size_t POPULATION = 64;
+
+/// Mean time of one call of operation over the pairs of the population
+double nanoseconds_per_call(size_t repeats,
+                            const std::function<void(size_t)> &operation) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < repeats; ++r) {
+    for (size_t i = 0; i < POPULATION; i += 2) {
+      operation(i);
+    }
+  }
+  const std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (repeats * POPULATION / 2);
+}
+
+void report(const std::string &name, double scalar, double batched) {
+  std::cout << name << ": " << scalar << "ns gene by gene, " << batched
+            << "ns batched (x" << scalar / batched << ")\n";
+}
+} // namespace
+
+int main(int argc, const char **argv) {
+  const size_t repeats = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const double mutation_rate = argc > 2 ? std::stod(argv[2]) : .01;
+  randf.seed(0);
+  random_stream random{0};
+
+  const segment<coordinates> landing_site{{0, 0}, {1000, 0}};
+  const auto parents = random_generation(POPULATION, {}, landing_site);
+  auto children = parents;
+  const auto pair = [&](size_t i) {
+    return std::tuple{parents.genes(i), parents.genes(i + 1),
+                      children.genes(i), children.genes(i + 1)};
+  };
+
+  std::cout << "Kernels: " << cpu_dispatch_variant() << ", " << repeats
+            << " times " << POPULATION / 2 << " pairs\n";
+
+  report("Linear interpolation",
+         nanoseconds_per_call(repeats,
+                              [&](size_t i) {
+                                std::apply(
+                                    scalar::crossover_linear_interpolation,
+                                    pair(i));
+                              }),
+         nanoseconds_per_call(repeats, [&](size_t i) {
+           auto [p1, p2, c1, c2] = pair(i);
+           crossover_linear_interpolation(p1, p2, c1, c2, random);
+         }));
+  report("Random selection",
+         nanoseconds_per_call(repeats,
+                              [&](size_t i) {
+                                std::apply(scalar::crossover_random_selection,
+                                           pair(i));
+                              }),
+         nanoseconds_per_call(repeats, [&](size_t i) {
+           auto [p1, p2, c1, c2] = pair(i);
+           crossover_random_selection(p1, p2, c1, c2, random);
+         }));
+  report("Alternate",
+         nanoseconds_per_call(repeats,
+                              [&](size_t i) {
+                                std::apply(scalar::crossover_alternate,
+                                           pair(i));
+                              }),
+         nanoseconds_per_call(repeats, [&](size_t i) {
+           auto [p1, p2, c1, c2] = pair(i);
+           crossover_alternate(p1, p2, c1, c2, random);
+         }));
+  report("Mutation at " + std::to_string(mutation_rate),
+         nanoseconds_per_call(repeats,
+                              [&](size_t i) {
+                                scalar::mutate(children.genes(i),
+                                               mutation_rate);
+                                scalar::mutate(children.genes(i + 1),
+                                               mutation_rate);
+                              }) /
+             2,
+         nanoseconds_per_call(repeats, [&](size_t i) {
+           mutate(children.genes(i), mutation_rate, random);
+           mutate(children.genes(i + 1), mutation_rate, random);
+         }) / 2);
+}
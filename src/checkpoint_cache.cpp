@@ -0,0 +1,63 @@
+#include "checkpoint_cache.hpp"
+#include "tracy_shim.hpp"
+#include "utility.hpp"
+
+void checkpoint_cache::set_interval(int interval) {
+  if (interval != interval_) {
+    clear();
+    interval_ = interval;
+  }
+}
+
+void checkpoint_cache::keys(individual_view ind, std::span<key> out) const {
+  ZoneScoped;
+  ASSERT(out.size() <= depth(ind.ticks()));
+  const auto interval = static_cast<size_t>(interval_);
+  auto h = individual::HASH_SEED;
+  for (size_t i = 0; i < out.size(); ++i) {
+    h = ind.commands_hash(i * interval, (i + 1) * interval, h);
+    out[i] = h;
+  }
+}
+
+const simulation::summary *
+checkpoint_cache::find(std::span<const key> keys) {
+  ZoneScoped;
+  stats_.lookups++;
+  entry *deepest = nullptr;
+  // Checkpoints are recorded along the whole trajectory, the first miss
+  // means no deeper match.
+  for (auto k : keys) {
+    auto it = checkpoints_.find(k);
+    if (it == checkpoints_.end()) {
+      break;
+    }
+    deepest = &it->second;
+    // Keep the whole prefix alive, resumed individuals don't record it again
+    deepest->last_used = generation_;
+  }
+  if (deepest == nullptr) {
+    return nullptr;
+  }
+  stats_.hits++;
+  stats_.ticks_skipped += deepest->state.ticks;
+  return &deepest->state;
+}
+
+void checkpoint_cache::insert(key k, const simulation::summary &state) {
+  ASSERT(state.final_status == simulation::status::none);
+  checkpoints_.insert_or_assign(k, entry{state, generation_});
+}
+
+void checkpoint_cache::next_generation() {
+  ZoneScoped;
+  generation_++;
+  std::erase_if(checkpoints_, [this](const auto &item) {
+    return generation_ - item.second.last_used > MAX_AGE;
+  });
+}
+
+void checkpoint_cache::clear() {
+  checkpoints_.clear();
+  stats_ = {};
+}
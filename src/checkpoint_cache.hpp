@@ -0,0 +1,70 @@
+#pragma once
+
+#include "individual.hpp"
+#include "simulation.hpp"
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+
+/// States reached by individuals every few ticks, keyed by the commands that
+/// led there. A decision only depends on the current state and on the
+/// command of the gene of its tick, the change of rotation and power it
+/// rounds to. Individuals asking for the same first n commands go through the
+/// same first n states, even when their genes differ by more bits than the
+/// rounding keeps: a child can resume from the deepest checkpoint of a parent
+/// it shares a prefix with instead of starting over from tick 0.
+/// Checkpoints are only valid for the scenario they were recorded on.
+struct checkpoint_cache {
+  using key = std::uint64_t;
+
+  struct statistics {
+    size_t lookups{0};
+    size_t hits{0};
+    size_t ticks_skipped{0};
+    size_t ticks_simulated{0};
+  };
+
+  explicit checkpoint_cache(int interval = 10) : interval_{interval} {}
+
+  [[nodiscard]] int interval() const { return interval_; }
+  void set_interval(int interval);
+
+  /// Number of checkpoints within the ticks decided by the genes alone, 0
+  /// when disabled. Keys past them would mix up individuals only differing by
+  /// their length.
+  [[nodiscard]] size_t depth(size_t ticks) const {
+    return interval_ > 0 ? ticks / interval_ : 0;
+  }
+
+  /// Writes the key of each of the checkpoints of the individual, as many
+  /// as out holds
+  void keys(individual_view ind, std::span<key> out) const;
+
+  /// Deepest checkpoint recorded along the given keys, or nullptr
+  const simulation::summary *find(std::span<const key> keys);
+
+  void insert(key k, const simulation::summary &state);
+
+  /// Drops the checkpoints that went unused during the last generations
+  void next_generation();
+
+  void clear();
+
+  [[nodiscard]] size_t size() const { return checkpoints_.size(); }
+  [[nodiscard]] const statistics &stats() const { return stats_; }
+  void count_simulated_ticks(size_t ticks) { stats_.ticks_simulated += ticks; }
+
+private:
+  constexpr static inline unsigned int MAX_AGE = 2;
+
+  struct entry {
+    simulation::summary state;
+    unsigned int last_used;
+  };
+
+  int interval_;
+  unsigned int generation_{0};
+  std::unordered_map<key, entry> checkpoints_;
+  statistics stats_;
+};
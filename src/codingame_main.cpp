@@ -25,7 +25,7 @@ int main() {
       .distance_weight = 1.,
       .rotation_weight = .1,
       .elite_multiplier = 5.,
-      .stdev_threshold = .1,
+      .stdev_threshold = .2,
   };
 
   std::vector<coordinates> points;
@@ -78,7 +78,7 @@ int main() {
   auto start = clock::now();
   auto total = clock::duration::zero();
   ga.simulate_initial_generation(params);
-  auto vals = ga.current_generation_results();
+  auto vals = ga.current_generation_summaries();
   decltype(total / ga.current_generation_name()) avg;
   auto min = clock::duration::max();
   auto max = clock::duration::min();
@@ -116,12 +116,12 @@ int main() {
         return best_idx;
       }
       ga.next_generation();
-      vals = ga.current_generation_results();
+      vals = ga.current_generation_summaries();
     }
   };
 
   size_t idx = play();
-  individual result = ga.current_generation()[idx];
+  individual result{ga.current_generation()[idx]};
   std::cerr << "Average time per generation: "
             << duration_cast<microseconds>(avg).count() << "us" << std::endl;
   std::cerr << "Min generation time: "
@@ -139,16 +139,17 @@ int main() {
   };
 
   while (1) {
-    auto d = result(current_data, points, 0);
+    auto d = result(current_data, points, current_frame);
 
     // We're not always forcing rotation to 0 correctly...
     std::cerr << "(" << d.rotate << "," << d.power << ") ";
-    for (size_t i = 1; i < result.genes.size(); ++i) {
-      auto e = result(current_data, points, i);
+    const auto ticks = static_cast<int>(result.view().ticks());
+    for (int frame = current_frame + 1; frame < ticks; ++frame) {
+      auto e = result(current_data, points, frame);
       std::cerr << "(" << e.rotate << "," << e.power << ") ";
-      result.genes[i - 1] = result.genes[i];
     }
     std::cerr << std::endl;
+    current_frame++;
 
     std::cout << d.rotate << " " << d.power << "\n";
     std::cin >> current_data.position.x >> current_data.position.y >>
@@ -156,5 +157,4 @@ int main() {
         current_data.fuel >> current_data.rotate >> current_data.power;
     std::cin.ignore();
   }
-  randf.stop();
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+// The hot kernels are compiled once per instruction set listed here and the
+// loader picks the best one the host supports, so a single binary runs at
+// full speed on every machine. None of the variants may fuse multiplications
+// and additions: every host has to simulate the same trajectories.
+// Define NO_CPU_DISPATCH to build the baseline only.
+#if defined(__x86_64__) && defined(__GNUC__) && defined(__ELF__) &&            \
+    !defined(NO_CPU_DISPATCH)
+#define CPU_DISPATCH_ENABLED
+#define CPU_DISPATCH __attribute__((target_clones("avx2", "sse4.2", "default")))
+#else
+#define CPU_DISPATCH
+#endif
+
+// Helpers of the kernels above that aren't worth a call: each variant gets its
+// own copy compiled for its instruction set.
+#if defined(__GNUC__)
+#define CPU_DISPATCH_INLINE inline __attribute__((always_inline))
+#else
+#define CPU_DISPATCH_INLINE inline
+#endif
+
+/// Instruction set of the kernel variants picked for this host
+inline const char *cpu_dispatch_variant() {
+#ifdef CPU_DISPATCH_ENABLED
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return "avx2";
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return "sse4.2";
+  }
+  return "default";
+#else
+  return "baseline";
+#endif
+}
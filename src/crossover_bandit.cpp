@@ -0,0 +1,47 @@
+#include "crossover_bandit.hpp"
+#include "selection.hpp"
+#include "utility.hpp"
+
+#include <numeric>
+
+void crossover_bandit::reset(size_t operators) {
+  credits_.assign(operators, 0.);
+  probabilities_.assign(operators, operators > 0 ? 1. / operators : 0.);
+  pending_.assign(operators, {});
+  totals_.assign(operators, {});
+}
+
+void crossover_bandit::draw(std::span<size_t> choices) const {
+  ASSERT(size() > 0);
+  // Probabilities are what the alias method expects from scores
+  const auto drawn =
+      select_parents(selection_method::alias, probabilities_, choices.size());
+  std::copy(drawn.begin(), drawn.end(), choices.begin());
+}
+
+void crossover_bandit::reward(size_t op, bool improved) {
+  ASSERT(op < size());
+  pending_[op].children++;
+  pending_[op].improvements += improved;
+}
+
+void crossover_bandit::update() {
+  for (size_t i = 0; i < size(); ++i) {
+    auto &pending = pending_[i];
+    if (pending.children > 0) {
+      const auto success = static_cast<double>(pending.improvements) /
+                           static_cast<double>(pending.children);
+      credits_[i] = DECAY * credits_[i] + (1 - DECAY) * success;
+    }
+    totals_[i].children += pending.children;
+    totals_[i].improvements += pending.improvements;
+    pending = {};
+  }
+
+  const auto total = std::accumulate(credits_.begin(), credits_.end(), 0.);
+  const auto even = 1. / static_cast<double>(size());
+  for (size_t i = 0; i < size(); ++i) {
+    probabilities_[i] =
+        total > 0 ? FLOOR * even + (1 - FLOOR) * credits_[i] / total : even;
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/// Odds of picking each crossover operator, following the share of its
+/// recent children that did better than their best parent. Every operator
+/// keeps a floor so that one out of favour can come back.
+class crossover_bandit {
+public:
+  explicit crossover_bandit(size_t operators = 0) { reset(operators); }
+
+  /// Even odds for that many operators, forgetting their history
+  void reset(size_t operators);
+
+  [[nodiscard]] size_t size() const { return credits_.size(); }
+
+  /// Operator of each pair of parents, drawn from randf
+  void draw(std::span<size_t> choices) const;
+
+  /// Records a child of the operator, whether it did better than its parents
+  void reward(size_t op, bool improved);
+
+  /// Folds the children recorded since the last call into the odds
+  void update();
+
+  [[nodiscard]] std::span<const double> probabilities() const {
+    return probabilities_;
+  }
+
+  struct statistics {
+    size_t children{0};
+    size_t improvements{0};
+  };
+  /// Children of each operator since the reset
+  [[nodiscard]] std::span<const statistics> stats() const { return totals_; }
+
+private:
+  /// Weight kept by the credit of the previous generations
+  constexpr static inline double DECAY = .8;
+  /// Share of the odds spread evenly over all operators
+  constexpr static inline double FLOOR = .3;
+
+  std::vector<double> credits_;
+  std::vector<double> probabilities_;
+  std::vector<statistics> pending_;
+  std::vector<statistics> totals_;
+};
@@ -0,0 +1,96 @@
+#include "diversity.hpp"
+#include "math.hpp"
+#include "tracy_shim.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+gene_moments::gene_moments(const population &gen) {
+  ZoneScoped;
+  reset(gen.length());
+  for (size_t i = 0; i < gen.size(); ++i) {
+    add(gen.genes(i));
+  }
+}
+
+void gene_moments::reset(size_t length) {
+  count_ = 0;
+  sums_.assign(2 * length, 0);
+  squares_.assign(2 * length, 0);
+}
+
+void gene_moments::add(const_genome genes) {
+  const auto length = std::min(genes.size(), this->length());
+  for (size_t j = 0; j < length; ++j) {
+    const std::uint64_t rotate = genes[j].rotate;
+    const std::uint64_t power = genes[j].power;
+    sums_[2 * j] += rotate;
+    sums_[2 * j + 1] += power;
+    squares_[2 * j] += rotate * rotate;
+    squares_[2 * j + 1] += power * power;
+  }
+  count_++;
+}
+
+void gene_moments::merge(const gene_moments &other) {
+  ASSERT(other.length() == length());
+  for (size_t k = 0; k < sums_.size(); ++k) {
+    sums_[k] += other.sums_[k];
+    squares_[k] += other.squares_[k];
+  }
+  count_ += other.count_;
+}
+
+double gene_moments::spread(size_t genes) const {
+  const auto length = std::min(genes, this->length());
+  if (count_ < 2 || length == 0) {
+    return 0;
+  }
+  double variance = 0;
+  const auto n = static_cast<double>(count_);
+  for (size_t k = 0; k < 2 * length; ++k) {
+    const auto mean = static_cast<double>(sums_[k]) / n;
+    variance +=
+        std::max(0., static_cast<double>(squares_[k]) / n - mean * mean);
+  }
+  variance /= static_cast<double>(2 * length);
+  // Variance of uniformly random genes
+  constexpr double RANGE = gene::MAX + 1.;
+  constexpr double UNIFORM = RANGE * RANGE / 12;
+  return std::sqrt(variance / UNIFORM);
+}
+
+diversity measure_diversity(const gene_moments &moments,
+                            std::span<const double> scores, size_t genes) {
+  ZoneScoped;
+  diversity result;
+  if (!scores.empty()) {
+    const auto [worst, best] = std::ranges::minmax(scores);
+    result.fitness_spread =
+        best > worst ? standard_deviation(scores) / (best - worst) : 0.;
+  }
+  result.gene_spread = moments.spread(genes);
+  return result;
+}
+
+diversity measure_diversity(const population &gen,
+                            std::span<const double> scores, size_t genes) {
+  return measure_diversity(gene_moments{gen}, scores, genes);
+}
+
+double adaptive_mutation::update(double base_rate, const diversity &d,
+                                 double fitness_target, double gene_target) {
+  const auto ratio = [](double spread, double target) {
+    return target > 0 ? spread / target : 1.;
+  };
+  const auto spread =
+      ratio(d.fitness_spread, fitness_target) * ratio(d.gene_spread, gene_target);
+  const auto wanted =
+      spread > 0 ? std::clamp(1 / spread, MIN_BOOST, MAX_BOOST) : MAX_BOOST;
+  // Halfway there on a log scale, one odd generation doesn't swing the rate
+  boost_ = std::sqrt(boost_ * wanted);
+  return std::min(base_rate * boost_, std::max(base_rate, MAX_RATE));
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "individual.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// How far a generation is from having converged
+struct diversity {
+  /// Standard deviation of the scores over their range, the part of the
+  /// score every individual gets doesn't weigh
+  double fitness_spread{0};
+  /// Standard deviation of the genes around the mean genome, 0 when every
+  /// individual is the same and 1 for uniformly random genes
+  double gene_spread{0};
+};
+
+/// Sums and sums of squares of the rotations then the powers of each gene
+/// over a generation, added up as its genomes get written
+class gene_moments {
+public:
+  gene_moments() = default;
+  /// Every row of the generation
+  explicit gene_moments(const population &gen);
+
+  /// No genome yet, each of the given length
+  void reset(size_t length);
+  void add(const_genome genes);
+  void merge(const gene_moments &other);
+
+  /// Genomes added
+  [[nodiscard]] size_t count() const { return count_; }
+  /// Genes of each genome
+  [[nodiscard]] size_t length() const { return sums_.size() / 2; }
+
+  /// Standard deviation of the first genes around the mean genome, 0 when
+  /// every genome is the same and 1 for uniformly random genes
+  [[nodiscard]] double spread(size_t genes) const;
+
+private:
+  size_t count_{0};
+  std::vector<std::uint64_t> sums_;
+  std::vector<std::uint64_t> squares_;
+};
+
+/// Single pass over the scores, the genes come summed up already. Genes read
+/// by no flight would look diverse whatever the generation.
+diversity measure_diversity(const gene_moments &moments,
+                            std::span<const double> scores, size_t genes);
+
+/// Same, summing the first genes of the generation up first
+diversity measure_diversity(const population &gen,
+                            std::span<const double> scores, size_t genes);
+
+/// Mutation rate following the diversity of the generations, inversely
+/// proportional to both spreads over their target: above the base rate once
+/// the generation converges past the targets, under it while it is still more
+/// diverse. The genes alone keep converging on the way to a landing.
+class adaptive_mutation {
+public:
+  /// Rate for the generation with the given diversity, a target of 0 ignores
+  /// its spread
+  double update(double base_rate, const diversity &d, double fitness_target,
+                double gene_target);
+
+  /// Factor applied to the base rate
+  [[nodiscard]] double boost() const { return boost_; }
+
+  void reset() { boost_ = 1; }
+
+private:
+  constexpr static inline double MIN_BOOST = .1;
+  constexpr static inline double MAX_BOOST = 10;
+  constexpr static inline double MAX_RATE = .25;
+
+  double boost_{1};
+};
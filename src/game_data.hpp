@@ -48,6 +48,8 @@ struct game_data {
     return simu_.history[next_frame_index_()];
   }
 
+  const simulation::result &result() const { return simu_; }
+
   size_t current_frame() const { return current_frame_; }
   size_t frame_count() const { return simu_.history.size(); }
 
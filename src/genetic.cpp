@@ -1,33 +1,124 @@
 #include "genetic.hpp"
+#include "acceleration_table.hpp"
+#include "breeding.hpp"
 #include "constants.hpp"
 #include "individual.hpp"
 #include "math.hpp"
 #include "random.hpp"
+#include "scenario_engine.hpp"
+#include "transposition_table.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <future>
 #include <limits>
 #include <mutex>
+#include <numbers>
+#include <tuple>
 
 simulation::input_data ga_data::initial_data_() const {
-  return {
-      .y_cutoff = y_cutoff_, .coords = coordinates_, .initial_data = initial_};
+  return {.ground = terrain_,
+          .coords = coordinates_,
+          .initial_data = initial_,
+          .doomed_check_interval = params_.doomed_check_interval,
+          .specialized_touchdown = specialized_touchdown_};
 }
 
 void ga_data::simulate_initial_generation(generation_parameters params) {
-  params_ = params;
-  current_generation_ =
-      random_generation(params.population_size, initial_, landing_site_);
+  set_params(params);
+  horizon_ = params.horizon > 0 ? params.horizon : INITIAL_HORIZON;
+  spacing_ = std::max(1u, params.control_spacing);
+  best_score_ = std::numeric_limits<fitness_score>::lowest();
+  stalled_ = 0;
+  refined_ = 0;
+  restarted_ = 0;
+  mutation_.reset();
+  stats_ = {};
+  {
+    std::lock_guard lock{mutex_};
+    mutation_trace_.clear();
+    restarts_.clear();
+  }
+  crossovers_.reset(crossover_operators().size());
+  offspring_.clear();
+  current_generation_ = random_generation(
+      params.population_size, initial_, terrain_.landing_site(),
+      genes_for(horizon_, spacing_), spacing_);
+  moments_ = gene_moments{current_generation_};
   current_generation_name_ = 1;
-  current_generation_results_ = simulate_(current_generation_, initial_data_());
+  current_generation_summaries_ =
+      simulate_(current_generation_, initial_data_());
+  perturbed_summaries_ =
+      simulate_perturbed_(current_generation_, initial_data_());
+  tainted_ = true;
+}
+
+ga_data::generation_result ga_data::current_generation_results() const {
+  ZoneScoped;
+  std::lock_guard lock{mutex_};
+  if (tainted_) {
+    auto input = initial_data_();
+    cached_results_.clear();
+    cached_results_.reserve(current_generation_.size());
+    for (size_t i = 0; i < current_generation_.size(); ++i) {
+      cached_results_.push_back(
+          simulation::simulate(input, current_generation_[i]));
+    }
+    tainted_ = false;
+  }
+  return cached_results_;
+}
+
+simulation::result ga_data::replay(size_t index) const {
+  ZoneScoped;
+  std::lock_guard lock{mutex_};
+  ASSERT(index < current_generation_.size());
+  return simulation::simulate(initial_data_(), current_generation_[index]);
+}
+
+void ga_data::sort_generation_results() {
+  std::lock_guard lock{mutex_};
+  std::vector<std::pair<fitness_score, size_t>> order;
+  order.reserve(current_generation_summaries_.size());
+  for (size_t i = 0; i < current_generation_summaries_.size(); ++i) {
+    order.emplace_back(score_(i), i);
+  }
+  std::sort(order.begin(), order.end(),
+            [](auto &a, auto &b) { return a.first > b.first; });
+
+  // Individuals follow their results so that replays stay consistent
+  const auto perturbed =
+      perturbed_summaries_.size() / std::max<size_t>(1, order.size());
+  auto &sorted_generation = spare_generation_;
+  sorted_generation.set_landing_site(current_generation_.landing_site());
+  sorted_generation.set_spacing(current_generation_.spacing());
+  sorted_generation.reset(order.size(), current_generation_.length());
+  generation_summary sorted_summaries;
+  generation_summary sorted_perturbed;
+  sorted_summaries.reserve(order.size());
+  sorted_perturbed.reserve(perturbed_summaries_.size());
+  for (size_t j = 0; j < order.size(); ++j) {
+    const auto i = order[j].second;
+    std::ranges::copy(current_generation_.genes(i),
+                      sorted_generation.genes(j).begin());
+    sorted_summaries.push_back(current_generation_summaries_[i]);
+    auto first = perturbed_summaries_.begin() + i * perturbed;
+    sorted_perturbed.insert(sorted_perturbed.end(), first, first + perturbed);
+  }
+  std::swap(current_generation_, sorted_generation);
+  current_generation_summaries_ = std::move(sorted_summaries);
+  perturbed_summaries_ = std::move(sorted_perturbed);
+  tainted_ = true;
 }
 
 ga_data::fitness_values
-ga_data::compute_fitness_values(const simulation::result &result,
+ga_data::compute_fitness_values(const simulation::summary &result,
                                 const generation_parameters &params,
                                 const segment<coordinates> &landing_site) {
   ZoneScoped;
-  const auto &last = result.history.back();
+  const auto &last = result.last;
   const auto square = [](auto x) { return x * x; };
   const fitness_score epsilon = std::numeric_limits<fitness_score>::epsilon();
 
@@ -50,8 +141,8 @@ ga_data::compute_fitness_values(const simulation::result &result,
 
   fitness_score remaining_fuel = last.fuel;
   coordinates position = last.position;
-  coordinates position_before_last =
-      result.history[result.history.size() - 2].position;
+  coordinates position_before_last = result.before_last.position;
+
 
   const double MAX_ABSOLUTE_DISTANCE =
       (double)distance(coordinates{0, 0}, coordinates{GAME_WIDTH, GAME_HEIGHT});
@@ -69,14 +160,20 @@ ga_data::compute_fitness_values(const simulation::result &result,
   values.dist_score =
       GAME_WIDTH - values.distance_x;// + (GAME_HEIGHT - values.distance_y) / 100;
 
-  if (values.distance < epsilon) {
+  // A doomed lander is scored as if it came down where it was found doomed,
+  // on the landing area when above it
+  const bool doomed = result.final_status == simulation::status::doomed;
+  const bool on_landing_area =
+      doomed ? values.distance_x < epsilon : values.distance < epsilon;
+  if (on_landing_area) {
     values.vertical_speed_score =
         std::clamp(100. - std::abs(last.velocity.y), 0., 100.);
     values.horizontal_speed_score =
         std::clamp(100. - std::abs(last.velocity.x), 0., 100.);
   }
 
-  if (result.final_status == simulation::status::crash_on_landing_area) {
+  if (result.final_status == simulation::status::crash_on_landing_area ||
+      (doomed && on_landing_area)) {
     values.rotation_score = std::clamp(90. - std::abs(last.rotate), 0., 90.);
   }
 
@@ -87,115 +184,32 @@ ga_data::compute_fitness_values(const simulation::result &result,
   values.score = values.dist_score + values.vertical_speed_score +
                  values.horizontal_speed_score + values.rotation_score +
                  values.fuel_score;
-  return values;
-}
-
-std::pair<size_t, size_t> selection(const ga_data::fitness_score_list &scores,
-                                    ga_data::fitness_score total) {
-  ZoneScoped;
-
-  // Roulette wheel selection, look into implementing the alias method. cf.
-  // wikipedia and
-  // https://gist.github.com/Liam0205/0b5786e9bfc73e75eb8180b5400cd1f8
-
-  auto r1 = randf() * total;
-  auto r2 = randf() * total;
-
-  constexpr auto MAX = std::numeric_limits<size_t>::max();
-  size_t p1 = MAX;
-  size_t p2 = MAX;
-  for (int i = 0; i < scores.size(); ++i) {
-    r1 -= scores[i];
-    r2 -= scores[i];
-    if (p1 == MAX && r1 <= 0) {
-      p1 = i;
-    }
-    if (p2 == MAX && r2 <= 0) {
-      p2 = i;
-    }
-    if (p1 != MAX && p2 != MAX) {
-      break;
-    }
-  }
-  ASSERT(p1 != MAX);
-  ASSERT(p2 != MAX);
-  return {p1, p2};
-}
-
-void crossover_linear_interpolation(const individual &p1, const individual &p2,
-                                    individual &child1, individual &child2) {
-  ZoneScoped;
-
-  for (int i = 0; i < child1.genes.size(); ++i) {
-    auto r = randf();
-
-    child1.genes[i].rotate =
-        r * p1.genes[i].rotate + (1 - r) * p2.genes[i].rotate;
-    child1.genes[i].power = r * p1.genes[i].power + (1 - r) * p2.genes[i].power;
-
-    child2.genes[i].rotate =
-        (1 - r) * p1.genes[i].rotate + r * p2.genes[i].rotate;
-    child2.genes[i].power = (1 - r) * p1.genes[i].power + r * p2.genes[i].power;
-  }
-}
-
-void crossover_random_selection(const individual &p1, const individual &p2,
-                                individual &child1, individual &child2) {
-  ZoneScoped;
-
-  for (int i = 0; i < child1.genes.size(); ++i) {
-    auto r = randf();
-    if (r < .5) {
-      child1.genes[i] = p1.genes[i];
-      child2.genes[i] = p2.genes[i];
-    } else {
-      child1.genes[i] = p2.genes[i];
-      child2.genes[i] = p1.genes[i];
-    }
-  }
-}
-
-void crossover_alternate(const individual &p1, const individual &p2,
-                         individual &child1, individual &child2) {
-  ZoneScoped;
-
-  for (int i = 0; i < child1.genes.size(); ++i) {
-    if (i % 2 == 0) {
-      child1.genes[i] = p1.genes[i];
-      child2.genes[i] = p2.genes[i];
-    } else {
-      child1.genes[i] = p2.genes[i];
-      child2.genes[i] = p1.genes[i];
-    }
-  }
-}
-
-void mutate(individual &p, const ga_data::generation_parameters &params,
-            double stdev) {
-  ZoneScoped;
-  auto mutation_rate = params.mutation_rate;
-  auto threshold = params.stdev_threshold;
-  for (auto &gene : p.genes) {
-    auto r = randf();
-    if (randf() < mutation_rate) {
-      gene.rotate = randf();
-    }
-    if (randf() < mutation_rate) {
-      gene.power = randf();
-    }
+  if (doomed) {
+    // Below any lander coming down at the same place, whatever its speeds
+    // and rotation
+    constexpr fitness_score DOOMED_PENALTY = 300;
+    values.score -= DOOMED_PENALTY;
   }
+  return values;
 }
 
-generation next_generation(
-    const generation &this_generation,
-    const std::vector<simulation::result> &current_generation_results,
+void next_generation(
+    const generation &this_generation, generation &new_generation,
+    const ga_data::generation_summary &current_generation_results,
     ga_data::fitness_score_list scores,
     const ga_data::generation_parameters &params,
-    const segment<coordinates> &landing_site) {
+    const segment<coordinates> &landing_site, size_t length,
+    const crossover_bandit *bandit,
+    std::vector<ga_data::offspring> &offspring, gene_moments &moments,
+    thread_pool &pool) {
   using fitness_score = ga_data::fitness_score;
 
-  generation new_generation;
-  new_generation.reserve(this_generation.size());
+  // Every row is overwritten below, the breeding tasks only write to them
+  new_generation.set_landing_site(landing_site);
+  new_generation.set_spacing(this_generation.spacing());
+  new_generation.reset(this_generation.size(), length);
+  // Genes past those of the parents keep the commands, as the parents did
+  const auto inherited = std::min(this_generation.length(), length);
 
   // Preprocessing
   fitness_score best_score = std::numeric_limits<fitness_score>::min();
@@ -215,41 +229,17 @@ generation next_generation(
     worst_score = 0;
   }
   // Elitism
-  // Choose a number of elites
   size_t elites =
       static_cast<size_t>(this_generation.size() * params.elitism_rate);
-  std::vector<std::pair<fitness_score, size_t>> elite_indices;
-  elite_indices.reserve(elites);
-
-  // Prefill the elite indices with the first values, sorted in descending order
-  for (int i = 0; i < elites; ++i) {
-    elite_indices.push_back({scores[i] * params.elite_multiplier, i});
-  }
-  std::sort(elite_indices.begin(), elite_indices.end(),
-            [](auto &a, auto &b) { return a.first > b.first; });
-
-  // Insertion sort bound by the number of elites wanted.
+  auto elite_indices = best_indices(scores, elites);
   if (elites != 0) {
-    for (size_t i = elites; i < scores.size(); ++i) {
-      for (size_t insert = 0; insert < elite_indices.size(); ++insert) {
-        auto adjusted_score = scores[i] * params.elite_multiplier;
-        if (adjusted_score > elite_indices[insert].first) {
-          elite_indices.insert(elite_indices.begin() + insert,
-                               {adjusted_score, i});
-          elite_indices.pop_back();
-          break;
-        }
-      }
-    }
-
     int landed = 0;
     int crashed_on_landing_area = 0;
-    for (size_t i = 0; i < elite_indices.size(); ++i) {
-      if (current_generation_results[elite_indices[i].second].final_status ==
+    for (auto i : elite_indices) {
+      if (current_generation_results[i].final_status ==
           simulation::status::land) {
         landed++;
-      } else if (current_generation_results[elite_indices[i].second]
-                     .final_status ==
+      } else if (current_generation_results[i].final_status ==
                  simulation::status::crash_on_landing_area) {
         crashed_on_landing_area++;
       }
@@ -266,136 +256,689 @@ generation next_generation(
     }
 
     ASSERT(elite_indices.size() == elites);
-    /* DEBUG_ONLY({
-      for (int i = 0; i < elite_indices.size() - 1; ++i) {
-        ASSERT(elite_indices[i].first >= elite_indices[i + 1].first);
-      }
-    }); */
-
-    for (size_t i = 0; i < elites; ++i) {
-      new_generation.push_back(this_generation[elite_indices[i].second]);
-    }
   }
 
   // Selection
-  fitness_score total = 0;
+  offspring.assign(this_generation.size(), {});
+  const auto raw_scores = scores;
   for (auto &score : scores) {
     score = (score - worst_score) / (best_score - worst_score);
-    DEBUG_ONLY(auto last = total);
-    total += score;
-    ASSERT(total >= last);
-  }
-
-  int crossover_style = 0;
-  double sd = standard_deviation(scores, total / scores.size());
-  while (new_generation.size() < this_generation.size()) {
-    ZoneScopedN("Selection, crossover and mutation");
-    auto [p1, p2] = selection(scores, total);
-
-    // Crossover
-    new_generation.push_back(this_generation[p1]);
-    new_generation.push_back(this_generation[p2]);
-    auto &child1 = *(new_generation.end() - 2);
-    auto &child2 = new_generation.back();
-
-    crossover_style = (crossover_style + 1) % 3;
-
-    if (crossover_style == 0) {
-      crossover_linear_interpolation(this_generation[p1], this_generation[p2],
-                                     child1, child2);
-    } else if (crossover_style == 1) {
-      crossover_random_selection(this_generation[p1], this_generation[p2],
-                                 child1, child2);
-    } else {
-      crossover_alternate(this_generation[p1], this_generation[p2], child1,
-                          child2);
+    ASSERT(score >= 0);
+  }
+
+  const auto children = this_generation.size() - elites;
+  const auto parents = select_parents(params.selection, scores,
+                                      children + children % 2,
+                                      params.tournament_size);
+
+  // Breeding: the elites then the pairs of parents, split in chunks of fixed
+  // size run on the pool. Each chunk draws from its own stream so the new
+  // generation only depends on the seed, not on the number of threads.
+  constexpr size_t CHUNK_SIZE = 32;
+  const auto pairs = parents.size() / 2;
+  const auto tasks = elites + pairs;
+
+  // Crossover of each pair, in turn unless they adapt to their results
+  const auto operators = crossover_operators();
+  std::vector<size_t> crossovers(pairs);
+  if (bandit != nullptr) {
+    ASSERT(bandit->size() == operators.size());
+    bandit->draw(crossovers);
+  } else {
+    for (size_t pair = 0; pair < pairs; ++pair) {
+      crossovers[pair] = (pair + 1) % operators.size();
     }
+  }
+  const auto seed = randf.next();
+  // Summed up by each chunk as its children are done, while they are at hand
+  std::vector<gene_moments> chunk_moments((tasks + CHUNK_SIZE - 1) /
+                                          CHUNK_SIZE);
+
+  const auto breed = [&](size_t begin, size_t end, random_stream &random,
+                         gene_moments &written) {
+    ZoneScopedN("Crossover and mutation");
+    written.reset(length);
+    std::vector<gene> spare;
+    for (auto task = begin; task < end; ++task) {
+      if (task < elites) {
+        const auto elite = new_generation.genes(task);
+        std::ranges::copy(
+            this_generation.genes(elite_indices[task]).first(inherited),
+            elite.begin());
+        std::ranges::fill(elite.subspan(inherited), gene::NEUTRAL);
+        // Keep the best individual as is to prevent regression
+        if (task > 0) {
+          mutate(new_generation.genes(task), params.mutation_rate, random);
+        }
+        written.add(elite);
+        continue;
+      }
 
-    // Mutation
-    mutate(new_generation[new_generation.size() - 2], params, sd);
+      const auto pair = task - elites;
+      const auto p1 = this_generation.genes(parents[2 * pair]).first(inherited);
+      const auto p2 =
+          this_generation.genes(parents[2 * pair + 1]).first(inherited);
+      const auto slot = elites + 2 * pair;
+      // The last pair may only have room for one child
+      const bool both = slot + 1 < new_generation.size();
+      if (!both) {
+        spare.resize(length);
+      }
 
-    // Drop extra child
-    if (new_generation.size() >= this_generation.size()) {
-      new_generation.pop_back();
-    } else {
-      mutate(new_generation.back(), params, sd);
+      // Crossover
+      const auto child1 = new_generation.genes(slot);
+      const auto child2 = both ? new_generation.genes(slot + 1) : genome{spare};
+      const auto crossover = crossovers[pair];
+      operators[crossover].apply(p1, p2, child1.first(inherited),
+                                 child2.first(inherited), random);
+      const ga_data::offspring origin{
+          .crossover = crossover,
+          .parent_score = std::max(raw_scores[parents[2 * pair]],
+                                   raw_scores[parents[2 * pair + 1]])};
+      offspring[slot] = origin;
+      if (both) {
+        offspring[slot + 1] = origin;
+      }
+      std::ranges::fill(child1.subspan(inherited), gene::NEUTRAL);
+      std::ranges::fill(child2.subspan(inherited), gene::NEUTRAL);
+
+      // Mutation
+      mutate(child1, params.mutation_rate, random);
+      written.add(child1);
+      if (both) {
+        mutate(child2, params.mutation_rate, random);
+        written.add(child2);
+      }
     }
-  }
+  };
 
-  // Mutate the elites at the end to keep their genes during selection
-  // but keep the best individual as is to prevent regression
-  for (size_t i = 1; i < elites; ++i) {
-    mutate(new_generation[i], params, sd);
+  std::vector<std::future<void>> futures;
+  futures.reserve((tasks + CHUNK_SIZE - 1) / CHUNK_SIZE);
+  for (size_t begin = 0, chunk = 0; begin < tasks;
+       begin += CHUNK_SIZE, ++chunk) {
+    std::packaged_task<void()> task(
+        [&breed, &chunk_moments, begin,
+         end = std::min(begin + CHUNK_SIZE, tasks), seed, chunk] {
+          random_stream random{seed, chunk};
+          breed(begin, end, random, chunk_moments[chunk]);
+        });
+    futures.push_back(task.get_future());
+    pool.push(std::move(task));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  moments.reset(length);
+  for (const auto &written : chunk_moments) {
+    moments.merge(written);
   }
-
-  return new_generation;
 }
 
 void ga_data::next_generation() {
   ZoneScoped;
 
   ga_data::fitness_score_list scores;
-  scores.reserve(current_generation_results_.size());
-  for (const auto &result : current_generation_results_) {
-    scores.push_back(
-        compute_fitness_values(result, params_, landing_site_).score);
+  scores.reserve(current_generation_summaries_.size());
+  for (size_t i = 0; i < current_generation_summaries_.size(); ++i) {
+    scores.push_back(score_(i));
   }
 
-  auto new_generation =
-      ::next_generation(current_generation_, current_generation_results_,
-                        std::move(scores), params_, landing_site_);
+  track_best_(scores);
+  refine_();
+  horizon_ = next_horizon_();
+
+  auto params = params_;
+  // Over the genes read by the best individual
+  const auto best = std::ranges::max_element(scores) - scores.begin();
+  const auto ticks =
+      scores.empty() ? 0 : current_generation_summaries_[best].ticks;
+  const auto spread =
+      measure_diversity(moments_, scores,
+                        genes_for(ticks, current_generation_.spacing()));
+  if (params.adapt_mutation_rate) {
+    params.mutation_rate = static_cast<float>(
+        mutation_.update(params.mutation_rate, spread, params.stdev_threshold,
+                         params.gene_spread_threshold));
+  }
+  {
+    std::lock_guard lock{mutex_};
+    mutation_trace_.push_back({spread, params.mutation_rate});
+  }
 
-  ASSERT(new_generation.size() == current_generation_.size());
+  if (crossovers_.size() != crossover_operators().size()) {
+    crossovers_.reset(crossover_operators().size());
+  }
+
+  // The spare generation isn't shared, only the swap needs the lock
+  if (restart_due_(spread)) {
+    restart_(scores, spread);
+  } else {
+    ::next_generation(current_generation_, spare_generation_,
+                      current_generation_summaries_, std::move(scores), params,
+                      terrain_.landing_site(), genes_for(horizon_, spacing_),
+                      params.adapt_crossover ? &crossovers_ : nullptr,
+                      offspring_, spare_moments_, tp_);
+  }
+
+  ASSERT(spare_generation_.size() == current_generation_.size());
+  ASSERT(spare_moments_.count() == spare_generation_.size());
 
   {
     std::lock_guard lock{mutex_};
-    current_generation_ = std::move(new_generation);
+    std::swap(current_generation_, spare_generation_);
   }
+  std::swap(moments_, spare_moments_);
   current_generation_name_++;
 
-  current_generation_results_ = simulate_(current_generation_, initial_data_());
+  auto summaries = simulate_(current_generation_, initial_data_());
+  auto perturbed = simulate_perturbed_(current_generation_, initial_data_());
+  {
+    std::lock_guard lock{mutex_};
+    current_generation_summaries_ = std::move(summaries);
+    perturbed_summaries_ = std::move(perturbed);
+    tainted_ = true;
+  }
+  reward_crossovers_();
 }
 
 void ga_data::prepare_initial_data_() {
-  coordinates last{-1, -1};
-  y_cutoff_ = std::numeric_limits<double>::min();
-  for (auto &coord : coordinates_) {
-    if (last.x != -1 && coord.y == last.y) {
-      landing_site_ = {last, coord};
-    }
-    if (coord.y > y_cutoff_) {
-      y_cutoff_ = coord.y;
-    }
-    last = coord;
+  terrain_ = terrain{coordinates_};
+  specialized_touchdown_ = find_specialized_touchdown(coordinates_);
+}
+
+transposition_table *ga_data::transposition_() {
+  // Looked up at checkpoints only
+  if (!transpositions_.enabled() || checkpoints_.interval() <= 0) {
+    return nullptr;
   }
+  return &transpositions_;
 }
 
 thread_pool ga_data::tp_{};
 
-ga_data::generation_result
-ga_data::simulate_(const generation &current_generation,
-                   const simulation::input_data &input) {
-  generation_result results;
-  using sim_results = simulation::result;
-  std::vector<std::future<sim_results>> futures;
+namespace {
+/// Flight of an individual with a timestep of stride ticks, for the screening
+/// pass. Each tick still gets the command of its gene within the limits of the
+/// lander, and the lander goes through the stride in closed form as far as
+/// those commands take it. Collisions, the landing approach and doom are only
+/// checked once per stride, along its chord: the flight is close to the exact
+/// one but for where and how fast it comes down.
+void coarse_flight(const simulation::input_data &input, individual_view ind,
+                   simulation::summary &state, int stride) {
+  const auto through = [&](const simulation_data &from, bool approach) {
+    auto data = from;
+    // Change of position and velocity due to the accelerations, the velocity
+    // of a tick moves the lander before its acceleration applies
+    double dx = 0;
+    double dy = 0;
+    double vx = 0;
+    double vy = 0;
+    for (int tick = 0; tick < stride; ++tick) {
+      const auto g = ind.at(static_cast<size_t>(state.ticks + tick));
+      // Straightens up over the landing site, as the individual does
+      data.rotate = simulation::clamp_rotation(
+          approach ? 0 : data.rotate + g.rotation_change(), data.rotate);
+      data.power = simulation::clamp_power(
+          approach ? data.power : data.power + g.power_change(), data.power,
+          data.fuel);
+      data.fuel -= data.power;
+      const auto a = acceleration_table::index(data.rotate, data.power);
+      dx += (stride - 1 - tick) * ACCELERATION.x[a];
+      dy += (stride - 1 - tick) * ACCELERATION.y[a];
+      vx += ACCELERATION.x[a];
+      vy += ACCELERATION.y[a];
+    }
+    data.position = {
+        static_cast<float>(from.position.x + stride * from.velocity.x + dx),
+        static_cast<float>(from.position.y + stride * from.velocity.y + dy)};
+    data.velocity = {static_cast<float>(from.velocity.x + vx),
+                     static_cast<float>(from.velocity.y + vy)};
+    return data;
+  };
 
-  auto size = current_generation.size();
-  results.reserve(size);
-  futures.reserve(size);
+  while (state.final_status == simulation::status::none) {
+    const auto from = state.last;
+    if (input.doomed_check_interval > 0 && simulation::doomed(from, input)) {
+      state.final_status = simulation::status::doomed;
+      return;
+    }
+    auto next = through(from, false);
+    if (segments_intersect(*ind.landing_site,
+                           segment<coordinates>{from.position, next.position})) {
+      next = through(from, true);
+    }
+    state.before_last = from;
+    state.last = next;
+    state.ticks += stride;
+    if (next.position.x < 0 || next.position.x > GAME_WIDTH ||
+        next.position.y < 0 || next.position.y > GAME_HEIGHT) {
+      state.final_status = simulation::status::lost;
+    } else {
+      std::tie(state.final_status, state.reason) =
+          simulation::touchdown(input, from.position, state.last);
+    }
+  }
+}
 
-  for (const auto &ind : current_generation) {
-    std::packaged_task<sim_results()> task(
-        [&input, individual = std::move(ind)]() {
-          return simulation::simulate(input, individual);
+/// Runs coarse_flight for the individuals still flying, on every worker of
+/// the pool
+void screen_on_pool(thread_pool &pool, const simulation::input_data &input,
+                    const generation &individuals,
+                    std::span<simulation::summary> states, int stride) {
+  const auto size = individuals.size();
+  const size_t chunk_size = (size + pool.size() - 1) / pool.size();
+  std::vector<std::future<void>> futures;
+  futures.reserve(pool.size());
+  for (size_t begin = 0; begin < size; begin += chunk_size) {
+    std::packaged_task<void()> task(
+        [&input, &individuals, states, stride, begin,
+         end = std::min(begin + chunk_size, size)] {
+          ZoneScopedN("Screening");
+          for (auto i = begin; i < end; ++i) {
+            coarse_flight(input, individuals[i], states[i], stride);
+          }
         });
+    futures.push_back(task.get_future());
+    pool.push(std::move(task));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+}
+
+using checkpoint = std::pair<size_t, simulation::summary>;
+
+/// Resumes the given landers on every worker of the pool, one batch each.
+/// Returns the checkpoints recorded on the way, indexed in processes.
+/// When given a table, the processes able to hash their remaining commands
+/// look a dead end up at each checkpoint and record the one they reach.
+template <DecisionProcess P>
+std::vector<checkpoint> resume_on_pool(thread_pool &pool,
+                                       const simulation::input_data &input,
+                                       std::span<const P> processes,
+                                       std::span<simulation::summary> states,
+                                       int checkpoint_interval,
+                                       transposition_table *table = nullptr) {
+  const auto size = processes.size();
+  std::vector<std::vector<checkpoint>> recorded(pool.size());
+  std::vector<std::future<void>> futures;
+
+  // One batch per worker, the batch engine takes care of the per tick work
+  const size_t chunk_size = (size + pool.size() - 1) / pool.size();
+  futures.reserve(pool.size());
+
+  for (size_t begin = 0, chunk = 0; begin < size;
+       begin += chunk_size, ++chunk) {
+    auto count = std::min(chunk_size, size - begin);
+    std::packaged_task<void()> task([&input, processes, states, &recorded,
+                                     checkpoint_interval, table, begin, count,
+                                     chunk]() {
+      using transposition = std::tuple<size_t, transposition_table::key, int>;
+      std::vector<transposition> pending;
+      simulation::resume_batch(
+          input, processes.subspan(begin, count), states.subspan(begin, count),
+          checkpoint_interval,
+          [&, begin](size_t i, simulation::summary &state) {
+            recorded[chunk].emplace_back(begin + i, state);
+            if constexpr (SuffixHashedProcess<P>) {
+              if (table != nullptr) {
+                const auto &process = processes[begin + i];
+                const auto from = static_cast<size_t>(state.ticks);
+                auto key = transposition_table::make_key(state.last,
+                                                         state.ticks);
+                if (auto found = table->find(key, state);
+                    found &&
+                    found->commands ==
+                        process.commands_hash(
+                            from, static_cast<size_t>(found->outcome.ticks),
+                            individual::HASH_SEED)) {
+                  table->count_hit();
+                  state = found->outcome;
+                } else {
+                  pending.emplace_back(begin + i, key, state.ticks);
+                }
+              }
+            }
+          });
+      if constexpr (SuffixHashedProcess<P>) {
+        for (auto [i, key, ticks] : pending) {
+          const auto &outcome = states[i];
+          if (!transposition_table::dead_end(outcome)) {
+            continue;
+          }
+          table->insert(key, ticks,
+                        {.outcome = outcome,
+                         .commands = processes[i].commands_hash(
+                             static_cast<size_t>(ticks),
+                             static_cast<size_t>(outcome.ticks),
+                             individual::HASH_SEED)});
+        }
+      }
+    });
 
     futures.push_back(task.get_future());
-    tp_.push(std::move(task));
+    pool.push(std::move(task));
   }
 
   for (auto &future : futures) {
-    results.push_back(future.get());
+    future.get();
+  }
+
+  std::vector<checkpoint> all;
+  for (auto &chunk : recorded) {
+    all.insert(all.end(), chunk.begin(), chunk.end());
   }
+  return all;
+}
+} // namespace
+
+ga_data::generation_summary
+ga_data::simulate_(const generation &current_generation,
+                   const simulation::input_data &input) {
+  ZoneScoped;
+  using clock = std::chrono::steady_clock;
+  auto size = current_generation.size();
+  generation_summary results(size, simulation::summary{input.initial_data});
+
+  // Individuals that went through unchanged get their previous result back
+  std::vector<std::uint64_t> hashes(size);
+  std::vector<bool> reused(size, false);
+  if (params_.reuse_results) {
+    for (size_t i = 0; i < size; ++i) {
+      hashes[i] = current_generation[i].hash();
+      stats_.reuse_lookups++;
+      if (auto it = previous_results_.find(hashes[i]);
+          it != previous_results_.end()) {
+        results[i] = it->second;
+        reused[i] = true;
+        stats_.reuse_hits++;
+      }
+    }
+  }
+
+  // Resume the others from the deepest state they share with an individual
+  // of the previous generations
+  checkpoints_.set_interval(params_.checkpoint_interval);
+  const auto depth = checkpoints_.depth(current_generation.ticks());
+  std::vector<checkpoint_cache::key> keys(size * depth);
+  size_t skipped_ticks = 0;
+  if (depth > 0) {
+    for (size_t i = 0; i < size; ++i) {
+      if (reused[i]) {
+        continue;
+      }
+      auto individual_keys = std::span{keys}.subspan(i * depth, depth);
+      checkpoints_.keys(current_generation[i], individual_keys);
+      if (auto *found = checkpoints_.find(individual_keys)) {
+        results[i] = *found;
+        skipped_ticks += found->ticks;
+      }
+    }
+  }
+
+  std::vector<bool> exact(size, true);
+  std::vector<checkpoint> recorded;
+  auto start = clock::now();
+  if (params_.screening_stride > 0 && params_.screening_fraction < 1) {
+    // Coarse pass over everyone, from the same starting states
+    auto starts = results;
+    screen_on_pool(tp_, input, current_generation, std::span{results},
+                   params_.screening_stride);
+
+    auto now = clock::now();
+    stats_.screening_time += now - start;
+    start = now;
+
+    // Only the most promising are worth the exact simulation, coarse
+    // landings always are
+    std::vector<std::pair<fitness_score, size_t>> candidates;
+    std::vector<size_t> promoted_indices;
+    for (size_t i = 0; i < size; ++i) {
+      if (reused[i]) {
+        continue;
+      }
+      if (results[i].success()) {
+        promoted_indices.push_back(i);
+      } else {
+        candidates.emplace_back(compute_fitness_values(results[i], params_,
+                                                       terrain_.landing_site())
+                                    .score,
+                                i);
+      }
+    }
+    const auto fraction = std::max(0.f, params_.screening_fraction);
+    const auto best_count =
+        std::min(candidates.size(), static_cast<size_t>(std::ceil(
+                                        candidates.size() * fraction)));
+    std::nth_element(candidates.begin(), candidates.begin() + best_count,
+                     candidates.end(),
+                     [](auto &a, auto &b) { return a.first > b.first; });
+    // The others keep their coarse outcome, which can't be a landing
+    for (size_t j = best_count; j < candidates.size(); ++j) {
+      exact[candidates[j].second] = false;
+    }
+    for (size_t j = 0; j < best_count; ++j) {
+      promoted_indices.push_back(candidates[j].second);
+    }
 
+    std::vector<individual_view> promoted;
+    generation_summary states;
+    promoted.reserve(promoted_indices.size());
+    states.reserve(promoted_indices.size());
+    for (auto i : promoted_indices) {
+      promoted.push_back(current_generation[i]);
+      states.push_back(starts[i]);
+    }
+    for (auto &[j, state] : resume_on_pool(
+             tp_, input, std::span{std::as_const(promoted)},
+             std::span{states}, checkpoints_.interval(), transposition_())) {
+      recorded.emplace_back(promoted_indices[j], std::move(state));
+    }
+    for (size_t j = 0; j < promoted_indices.size(); ++j) {
+      results[promoted_indices[j]] = states[j];
+    }
+    // The checkpoint cache only accounts for exact simulations
+    for (auto [score, i] : std::span{candidates}.subspan(best_count)) {
+      skipped_ticks -= starts[i].ticks;
+    }
+    stats_.screened += size;
+    stats_.promoted += promoted_indices.size();
+  } else {
+    const auto views = current_generation.views();
+    recorded = resume_on_pool(tp_, input, std::span{views},
+                              std::span{results}, checkpoints_.interval(),
+                              transposition_());
+  }
+  stats_.exact_time += clock::now() - start;
+
+  for (const auto &[i, state] : recorded) {
+    auto n = static_cast<size_t>(state.ticks / checkpoints_.interval());
+    if (n <= depth) {
+      checkpoints_.insert(keys[i * depth + n - 1], state);
+    }
+  }
+  checkpoints_.next_generation();
+
+  size_t total_ticks = 0;
+  previous_results_.clear();
+  for (size_t i = 0; i < size; ++i) {
+    if (!reused[i] && exact[i]) {
+      total_ticks += results[i].ticks;
+    }
+    // Screened out results are only estimates
+    if (params_.reuse_results && exact[i]) {
+      previous_results_.insert_or_assign(hashes[i], results[i]);
+    }
+  }
+  checkpoints_.count_simulated_ticks(total_ticks - skipped_ticks);
+
+  return results;
+}
+
+ga_data::generation_summary
+ga_data::simulate_perturbed_(const generation &current_generation,
+                             const simulation::input_data &input) {
+  ZoneScoped;
+  const auto count =
+      static_cast<size_t>(std::max(0, params_.perturbed_scenarios));
+  if (count == 0) {
+    return {};
+  }
+
+  // Initial speeds spread evenly around the given one
+  std::vector<simulation::summary> starts;
+  starts.reserve(count);
+  for (size_t j = 0; j < count; ++j) {
+    const auto angle = 2 * std::numbers::pi * j / count;
+    auto data = input.initial_data;
+    data.velocity.x += params_.velocity_perturbation * std::cos(angle);
+    data.velocity.y += params_.velocity_perturbation * std::sin(angle);
+    starts.emplace_back(data);
+  }
+
+  // A single pass over every run, all of them on the same terrain. Cached
+  // states and results only hold for the scenario as given.
+  std::vector<individual_view> processes;
+  generation_summary results;
+  processes.reserve(current_generation.size() * count);
+  results.reserve(current_generation.size() * count);
+  for (size_t i = 0; i < current_generation.size(); ++i) {
+    for (const auto &start : starts) {
+      processes.push_back(current_generation[i]);
+      results.push_back(start);
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  resume_on_pool(tp_, input, std::span{std::as_const(processes)},
+                 std::span{results}, 0);
+  stats_.perturbed_time += std::chrono::steady_clock::now() - start;
   return results;
 }
+
+ga_data::fitness_score ga_data::score_(size_t index) const {
+  const auto &landing_site = terrain_.landing_site();
+  auto score = compute_fitness_values(current_generation_summaries_[index],
+                                      params_, landing_site)
+                   .score;
+  const auto count = perturbed_summaries_.size() /
+                     std::max<size_t>(1, current_generation_summaries_.size());
+  for (size_t j = index * count; j < (index + 1) * count; ++j) {
+    score += compute_fitness_values(perturbed_summaries_[j], params_,
+                                    landing_site)
+                 .score;
+  }
+  return score / static_cast<fitness_score>(count + 1);
+}
+
+size_t ga_data::next_horizon_() const {
+  if (params_.horizon > 0) {
+    return params_.horizon;
+  }
+  // Flights outlasting the genes go on with the commands held, their genes
+  // would be read if there were any
+  int longest = 0;
+  for (const auto &summary : current_generation_summaries_) {
+    longest = std::max(longest, summary.ticks);
+  }
+  for (const auto &summary : perturbed_summaries_) {
+    longest = std::max(longest, summary.ticks);
+  }
+
+  // Some room for the children to fly longer than their parents, in whole
+  // blocks of the breeding operators
+  constexpr size_t MIN_HORIZON = 32;
+  constexpr size_t MAX_HORIZON = 1024;
+  constexpr size_t BLOCK = 4;
+  auto target = static_cast<size_t>(longest) * 5 / 4 + BLOCK;
+  target = std::clamp((target + BLOCK - 1) / BLOCK * BLOCK, MIN_HORIZON,
+                      MAX_HORIZON);
+  if (target >= horizon_) {
+    return target;
+  }
+  // Shrinking drops genes for good, it goes slowly in case flights get longer
+  // again
+  return std::max(target, (horizon_ - horizon_ / 8) / BLOCK * BLOCK);
+}
+
+void ga_data::track_best_(const fitness_score_list &scores) {
+  if (scores.empty()) {
+    return;
+  }
+  const auto best = *std::ranges::max_element(scores);
+  if (best > best_score_) {
+    best_score_ = best;
+    stalled_ = 0;
+    refined_ = 0;
+    restarted_ = 0;
+  } else {
+    stalled_++;
+    refined_++;
+    restarted_++;
+  }
+}
+
+void ga_data::refine_() {
+  if (refined_ == 0 || refined_ < params_.refine_patience || spacing_ == 1) {
+    return;
+  }
+  // The scores still hold, the commands barely change
+  refined_ = 0;
+  spacing_ = std::max(1u, spacing_ / 2);
+  respace(current_generation_, spare_generation_, spacing_);
+  // Rewritten outside of the breeding, summed up again
+  moments_ = gene_moments{spare_generation_};
+  std::lock_guard lock{mutex_};
+  std::swap(current_generation_, spare_generation_);
+  tainted_ = true;
+}
+
+void ga_data::reward_crossovers_() {
+  for (size_t i = 0; i < offspring_.size(); ++i) {
+    const auto &child = offspring_[i];
+    if (child.crossover != offspring::NO_CROSSOVER) {
+      crossovers_.reward(child.crossover, score_(i) > child.parent_score);
+    }
+  }
+  crossovers_.update();
+}
+
+bool ga_data::restart_due_(const diversity &spread) const {
+  if (params_.restart_patience == 0 || restarted_ == 0) {
+    return false;
+  }
+  return restarted_ >= params_.restart_patience ||
+         spread.fitness_spread < params_.restart_spread;
+}
+
+void ga_data::restart_(const fitness_score_list &scores,
+                       const diversity &spread) {
+  ZoneScoped;
+  const auto size = current_generation_.size();
+  const auto survivors = best_indices(
+      scores, std::max<size_t>(1, static_cast<size_t>(
+                                      size * params_.restart_survivors)));
+  const auto length = genes_for(horizon_, spacing_);
+  // In place, the spare generation keeps its buffer
+  spare_generation_.set_landing_site(terrain_.landing_site());
+  spare_generation_.set_spacing(spacing_);
+  spare_generation_.reset(size, length);
+  randomize(spare_generation_);
+  // Over the individuals holding a command all along, the random ones are
+  // the point
+  const auto inherited = std::min(length, current_generation_.length());
+  for (size_t i = 0; i < survivors.size(); ++i) {
+    const auto genes = spare_generation_.genes(i);
+    std::ranges::copy(current_generation_.genes(survivors[i]).first(inherited),
+                      genes.begin());
+    std::ranges::fill(genes.subspan(inherited), gene::NEUTRAL);
+  }
+  spare_moments_ = gene_moments{spare_generation_};
+  offspring_.assign(size, {});
+
+  std::lock_guard lock{mutex_};
+  restarts_.push_back({.generation = current_generation_name_,
+                       .best_score = best_score_,
+                       .stalled = stalled_,
+                       .spread = spread});
+  restarted_ = 0;
+}
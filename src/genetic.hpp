@@ -1,18 +1,29 @@
 #pragma once
 
+#include "breeding.hpp"
+#include "checkpoint_cache.hpp"
+#include "crossover_bandit.hpp"
+#include "diversity.hpp"
 #include "individual.hpp"
+#include "selection.hpp"
 #include "simulation.hpp"
 #include "simulation_data.hpp"
+#include "terrain.hpp"
 #include "threadpool.hpp"
+#include "transposition_table.hpp"
 
 #include <atomic>
+#include <cstdint>
+#include <limits>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 struct ga_data {
   using fitness_score = double;
 
   using generation_result = std::vector<simulation::result>;
+  using generation_summary = std::vector<simulation::summary>;
   using fitness_score_list = std::vector<fitness_score>;
 
   struct generation_parameters {
@@ -26,7 +37,108 @@ struct ga_data {
     float distance_weight = 1.;
     float rotation_weight = .1;
     float elite_multiplier = 5.;
-    float stdev_threshold = .1;
+    /// Spread of the scores, their standard deviation over their range, at
+    /// which an adaptive mutation rate stays at mutation_rate: it is raised
+    /// under it and lowered over it. Around the middle of the runs on the
+    /// example maps.
+    float stdev_threshold = .2;
+    /// How parents are drawn according to their fitness
+    selection_method selection = selection_method::alias;
+    /// Individuals competing for each parent in a tournament selection
+    unsigned int tournament_size = 3;
+
+    /// Ticks between two cached simulation states, 0 disables the cache
+    int checkpoint_interval = 10;
+    /// Give individuals identical to one of the previous generation its
+    /// result back instead of simulating them again
+    bool reuse_results = true;
+    /// Ticks between two checks ending the simulation of individuals that
+    /// can no longer land, 0 simulates all of them to the end
+    int doomed_check_interval = 5;
+    /// Timestep, in ticks, of the coarse pass screening the whole generation,
+    /// 0 simulates everyone exactly in one pass
+    int screening_stride = 0;
+    /// Share of the generation going through the exact simulation after the
+    /// coarse pass, the others keep their coarse result
+    float screening_fraction = .3;
+    /// Bytes given to the table of dead ends shared by individuals going
+    /// through nearly the same states with the same commands left, 0 disables
+    /// it. Looked up at checkpoints, the crashes found there are approximate.
+    size_t transposition_memory = 0;
+    /// Copies of the scenario with perturbed initial speeds each individual
+    /// is also simulated on, its fitness is then averaged over all of them.
+    /// 0 only simulates the scenario as given.
+    int perturbed_scenarios = 0;
+    /// Change of the initial speed in the perturbed scenarios, in m/s
+    float velocity_perturbation = 2.;
+    /// Ticks planned for by each individual, 0 follows the length of the
+    /// recent flights. The lander holds its commands past the last gene.
+    unsigned int horizon = 0;
+    /// Ticks between two genes of the first generation, the commands in
+    /// between are interpolated from these control points. 1 gives each tick
+    /// its own gene.
+    unsigned int control_spacing = 1;
+    /// Generations without a better best score after which the control
+    /// points get twice as close, down to one per tick
+    unsigned int refine_patience = 5;
+    /// Scale the mutation rate with the lack of diversity of the generation,
+    /// both in its scores and in its genes
+    bool adapt_mutation_rate = false;
+    /// Spread of the genes at which an adaptive mutation rate stays at
+    /// mutation_rate, 1 being that of random genes. The runs on the example
+    /// maps never go much under .3.
+    float gene_spread_threshold = .4;
+    /// Pick the crossover of each pair according to how often its recent
+    /// children beat their parents, instead of each in turn
+    bool adapt_crossover = false;
+    /// Generations without a better best score after which the population
+    /// starts over from random individuals but for its best ones, 0 never
+    /// restarts
+    unsigned int restart_patience = 0;
+    /// Spread of the scores under which a generation that didn't improve
+    /// restarts without waiting for restart_patience, 0 always waits
+    float restart_spread = 0;
+    /// Share of the population kept through a restart, the best first
+    float restart_survivors = .1;
+  };
+
+  /// Counted since the last initial generation, but for the checkpoints
+  /// kept along with the cache
+  struct statistics {
+    checkpoint_cache::statistics checkpoints;
+    size_t reuse_lookups{0};
+    size_t reuse_hits{0};
+    /// Individuals through each evaluation stage and the time spent in it
+    size_t screened{0};
+    size_t promoted{0};
+    simulation::duration screening_time{0};
+    simulation::duration exact_time{0};
+    simulation::duration perturbed_time{0};
+    transposition_table::statistics transpositions;
+  };
+
+  /// Crossover a child came out of and the best score of its parents
+  struct offspring {
+    constexpr static inline size_t NO_CROSSOVER = -1;
+
+    size_t crossover{NO_CROSSOVER};
+    fitness_score parent_score{0};
+  };
+
+  /// Population started over instead of breeding a generation
+  struct restart {
+    unsigned int generation;
+    fitness_score best_score;
+    /// Generations the best score went without improving
+    unsigned int stalled;
+    /// Diversity of the generation replaced
+    diversity spread;
+  };
+
+  /// Diversity of a generation and the mutation rate it was bred with
+  struct mutation_sample {
+    diversity spread;
+    double mutation_rate;
   };
 
   ga_data(coordinate_list coordinates = {}, simulation_data initial = {})
@@ -41,43 +153,98 @@ struct ga_data {
     coordinates_ = std::move(coordinates);
     initial_ = std::move(initial);
     prepare_initial_data_();
-    current_generation_results_.clear();
+    current_generation_summaries_.clear();
+    perturbed_summaries_.clear();
     current_generation_name_ = 0;
+    horizon_ = INITIAL_HORIZON;
+    spacing_ = 1;
+    mutation_.reset();
+    mutation_trace_.clear();
+    crossovers_.reset(crossover_operators().size());
+    offspring_.clear();
+    restarts_.clear();
     current_generation_.clear();
+    spare_generation_.clear();
+    moments_ = {};
+    spare_moments_ = {};
+    checkpoints_.clear();
+    previous_results_.clear();
+    transpositions_.clear();
+    stats_ = {};
+    tainted_ = true;
   }
 
-  generation_result current_generation_results() const {
+  generation_summary current_generation_summaries() const {
     std::lock_guard lock{mutex_};
-    return current_generation_results_;
+    return current_generation_summaries_;
   }
 
+  /// Full trajectories of the current generation. They aren't kept by the
+  /// simulation, the whole generation is replayed on the first call.
+  generation_result current_generation_results() const;
+
+  /// Rebuilds the full trajectory of one individual of the current generation
+  simulation::result replay(size_t index) const;
+
   size_t generation_size() const {
     std::lock_guard lock{mutex_};
     return current_generation_.size();
   }
 
-  void sort_generation_results() {
-    std::lock_guard lock{mutex_};
-    std::sort(current_generation_results_.begin(), current_generation_results_.end(),
-              [this](simulation::result &a, simulation::result &b) {
-                return compute_fitness_values(a, params_,landing_site_).score > compute_fitness_values(b, params_,landing_site_).score;
-              });
-  }
+  void sort_generation_results();
 
   bool generated() const {
     std::lock_guard lock{mutex_};
-    return !current_generation_results_.empty();
+    return !current_generation_summaries_.empty();
   }
 
   void next_generation();
+
+  /// One sample per generation bred so far
+  std::vector<mutation_sample> mutation_trace() const {
+    std::lock_guard lock{mutex_};
+    return mutation_trace_;
+  }
+
+  /// Every restart so far
+  std::vector<restart> restarts() const {
+    std::lock_guard lock{mutex_};
+    return restarts_;
+  }
+
+  /// Odds and results of each crossover operator, whether they adapt or not
+  const crossover_bandit &crossovers() const { return crossovers_; }
+
+  statistics stats() const {
+    auto s = stats_;
+    s.checkpoints = checkpoints_.stats();
+    s.transpositions = transpositions_.stats();
+    return s;
+  }
+
   void set_params(generation_parameters params) {
     std::lock_guard lock{mutex_};
+    if (params.doomed_check_interval != params_.doomed_check_interval) {
+      // Cached states and results depend on when simulations were cut short
+      checkpoints_.clear();
+      previous_results_.clear();
+      transpositions_.clear();
+      tainted_ = true;
+    }
+    if (params.transposition_memory != params_.transposition_memory) {
+      transpositions_.resize(params.transposition_memory);
+    }
     params_ = params;
   }
 
   size_t current_generation_name() const { return current_generation_name_; }
 
-  const std::vector<individual> &current_generation() const {
+  /// Ticks planned for by the individuals of the current generation
+  size_t horizon() const { return horizon_; }
+  /// Ticks between two genes of the current generation
+  unsigned int spacing() const { return spacing_; }
+
+  const generation &current_generation() const {
     return current_generation_;
   }
 
@@ -102,7 +269,7 @@ struct ga_data {
   };
 
   static fitness_values
-  compute_fitness_values(const simulation::result &result,
+  compute_fitness_values(const simulation::summary &result,
                          const generation_parameters &params,
                          const segment<coordinates> &landing_site);
 
@@ -112,22 +279,68 @@ private:
 
   generation_parameters params_;
   generation current_generation_;
-  generation_result current_generation_results_;
+  /// Where the next generation is bred, swapped with the current one after
+  /// that so that neither gets allocated again
+  generation spare_generation_;
+  /// Genes of both generations summed up, for their diversity
+  gene_moments moments_;
+  gene_moments spare_moments_;
+  generation_summary current_generation_summaries_;
+  /// Results on the perturbed scenarios, those of an individual next to each
+  /// other
+  generation_summary perturbed_summaries_;
   mutable generation_result cached_results_;
   unsigned int current_generation_name_{0};
+  size_t horizon_{INITIAL_HORIZON};
+  unsigned int spacing_{1};
+  /// Best score so far and the generations since it last improved, since
+  /// the last refinement and since the last restart
+  fitness_score best_score_{std::numeric_limits<fitness_score>::lowest()};
+  unsigned int stalled_{0};
+  unsigned int refined_{0};
+  unsigned int restarted_{0};
+  std::vector<restart> restarts_;
+  adaptive_mutation mutation_;
+  std::vector<mutation_sample> mutation_trace_;
+  crossover_bandit crossovers_;
+  /// Where each individual of the current generation comes from
+  std::vector<offspring> offspring_;
 
   // Initial data
   coordinate_list coordinates_;
   simulation_data initial_;
-  double y_cutoff_;
+  terrain terrain_;
+  simulation::touchdown_function specialized_touchdown_{nullptr};
   simulation::input_data initial_data_() const;
 
   void prepare_initial_data_();
 
-  static generation_result simulate_(const generation &current_generation,
-                                     const simulation::input_data &initial);
+  checkpoint_cache checkpoints_;
+  std::unordered_map<std::uint64_t, simulation::summary> previous_results_;
+  statistics stats_;
+  transposition_table transpositions_;
+  transposition_table *transposition_();
+
+  generation_summary simulate_(const generation &current_generation,
+                               const simulation::input_data &initial);
+  generation_summary
+  simulate_perturbed_(const generation &current_generation,
+                      const simulation::input_data &initial);
+
+  /// Fitness of the individual at index over every scenario it went through
+  fitness_score score_(size_t index) const;
 
-  segment<coordinates> landing_site_{};
+  /// Ticks the next generation needs to cover the flights of this one
+  size_t next_horizon_() const;
+  void track_best_(const fitness_score_list &scores);
+  /// Brings the control points closer once the best score stops improving
+  void refine_();
+  /// Whether the population is stuck enough to start over
+  bool restart_due_(const diversity &spread) const;
+  /// Next generation made of the best individuals and random ones
+  void restart_(const fitness_score_list &scores, const diversity &spread);
+  /// Credits the crossovers with the children of the current generation
+  void reward_crossovers_();
 
   static thread_pool tp_;
 };
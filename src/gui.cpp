@@ -47,6 +47,8 @@ std::string_view to_string(enum simulation::status status) {
     return "Crashed";
   case simulation::status::lost:
     return "Lost";
+  case simulation::status::doomed:
+    return "Doomed";
   }
   return "Unknown";
 }
@@ -282,7 +284,7 @@ bool input_rate(const char *label, float &value, float min = 0.0f,
 
 int draw_generation_results(const world_data &world) {
   int selected = -1;
-  auto results = world.current_generation_results();
+  auto results = world.current_generation_summaries();
   std::vector<size_t> landed;
   std::vector<std::pair<size_t, ga_data::fitness_values>> fitness_values;
   std::vector<ga_data::fitness_score> scores;
@@ -410,8 +412,36 @@ bool draw_algorithm_parameters(ga_data::generation_parameters &params) {
   update_needed |=
       input_rate("Score hspeed weight", params.horizontal_speed_weight);
   update_needed |= input_rate("Score rotation weight", params.rotation_weight);
+  update_needed |=
+      ImGui::Checkbox("Adaptive mutation rate", &params.adapt_mutation_rate);
   update_needed |= input_rate("Standard deviation threshold",
                               params.stdev_threshold, 0., 100.);
+  update_needed |=
+      input_rate("Gene spread threshold", params.gene_spread_threshold);
+
+  constexpr const char *selection_methods[] = {
+      "Roulette wheel", "Roulette wheel (alias method)",
+      "Stochastic universal sampling", "Tournament"};
+  int selection = static_cast<int>(params.selection);
+  if (ImGui::Combo("Selection", &selection, selection_methods,
+                   IM_ARRAYSIZE(selection_methods))) {
+    params.selection = static_cast<selection_method>(selection);
+    update_needed = true;
+  }
+  update_needed |=
+      ImGui::Checkbox("Adaptive crossover", &params.adapt_crossover);
+  int patience = static_cast<int>(params.restart_patience);
+  if (ImGui::InputInt("Restart patience", &patience)) {
+    params.restart_patience = static_cast<unsigned int>(std::max(0, patience));
+    update_needed = true;
+  }
+  if (params.selection == selection_method::tournament) {
+    int size = static_cast<int>(params.tournament_size);
+    if (ImGui::InputInt("Tournament size", &size)) {
+      params.tournament_size = static_cast<unsigned int>(std::max(1, size));
+      update_needed = true;
+    }
+  }
   return update_needed;
 }
 
@@ -491,7 +521,8 @@ void draw_ga_control(world_data &world) {
           draw_frame_data("Selected individual", results.history.back());
           ImGui::Separator();
           draw_fitness_values(ga_data::compute_fitness_values(
-              results, world.ga_params, world.landing_site()));
+              simulation::summary{results}, world.ga_params,
+              world.landing_site()));
           draw_history(results, world);
         }
       }
@@ -3,9 +3,32 @@
 #include "random.hpp"
 #include "utility.hpp"
 
-decision individual::operator()(const simulation_data &data,
-                                const std::vector<coordinates> &ground_line,
-                                int current_frame) const {
+#include <array>
+#include <bit>
+
+namespace {
+// Multiply-xorshift, exact equality is what matters. The hashes run over
+// whole genomes every generation so it is kept short.
+std::uint64_t mix(std::uint64_t h, std::uint64_t x) {
+  h = (h ^ x) * 0x9e3779b97f4a7c15;
+  return h ^ (h >> 32);
+}
+
+decision follow(const simulation_data &data, const gene &g) {
+  decision result{
+      .rotate = std::clamp(data.rotate + g.rotation_change(), -MAX_ROTATION,
+                           MAX_ROTATION),
+      .power = std::clamp(data.power + g.power_change(), 0, MAX_POWER),
+  };
+  ASSERT(result.rotate >= -MAX_ROTATION && result.rotate <= MAX_ROTATION);
+  ASSERT(result.power >= 0 && result.power <= MAX_POWER);
+  return result;
+}
+} // namespace
+
+decision individual_view::operator()(const simulation_data &data,
+                                     const std::vector<coordinates> &ground_line,
+                                     int current_frame) const {
   auto next_pos = data.position + data.velocity;
   coordinates top_left = {
       std::min(data.position.x, next_pos.x),
@@ -16,68 +39,144 @@ decision individual::operator()(const simulation_data &data,
       std::max(data.position.y, next_pos.y),
   };
 
-  if (top_left.x <= landing_site_.end.x ||
-      bottom_right.x >= landing_site_.start.x) {
+  const bool approaching =
+      (top_left.x <= landing_site->end.x ||
+       bottom_right.x >= landing_site->start.x) &&
+      segments_intersect(*landing_site, {data.position, next_pos});
+  return decide(data, current_frame, approaching);
+}
+
+decision individual_view::decide(const simulation_data &data,
+                                 int current_frame, bool approaching) const {
+  if (approaching) {
+    return {.rotate = 0, .power = data.power};
+  }
+  return follow(data, at(static_cast<size_t>(current_frame)));
+}
 
-    if (segments_intersect(landing_site_, {data.position, next_pos})) {
-      return {.rotate = 0, .power = data.power};
+gene individual_view::at(size_t frame) const {
+  if (spacing == 1) {
+    return frame < size ? genes[frame] : gene::NEUTRAL;
+  }
+  const auto i = frame / spacing;
+  const auto offset = frame % spacing;
+  if (i >= size) {
+    return gene::NEUTRAL;
+  }
+  if (offset == 0) {
+    return genes[i];
+  }
+  // Linear from this control point to the next one, rounded down
+  const auto &next = i + 1 < size ? genes[i + 1] : gene::NEUTRAL;
+  const auto lerp = [&](std::uint32_t a, std::uint32_t b) {
+    return static_cast<std::uint16_t>((a * (spacing - offset) + b * offset) /
+                                      spacing);
+  };
+  return {lerp(genes[i].rotate, next.rotate), lerp(genes[i].power, next.power)};
+}
+
+int individual_view::hold(const simulation_data &data,
+                          int current_frame) const {
+  // Rotation and power don't change as long as each gene asks for the current
+  // values, so the next genes can be checked against the same state.
+  // The landing approach only kicks in when crossing the landing site, the
+  // simulation makes sure the lander stays clear of the ground.
+  int ticks = 0;
+  for (auto frame = static_cast<size_t>(current_frame); frame < size * spacing;
+       ++frame) {
+    auto d = follow(data, at(frame));
+    if (d.rotate != data.rotate || d.power != data.power) {
+      return ticks;
     }
+    ticks++;
   }
+  // Past the genome everything holds, asked again once that many are over
+  constexpr int PAST_GENOME_TICKS = 256;
+  return ticks + PAST_GENOME_TICKS;
+}
 
-  auto current_position = data.position;
-  auto next_position = data.position + data.velocity;
+std::uint64_t individual_view::hash() const {
+  auto length = size;
+  while (length > 0 && genes[length - 1] == gene::NEUTRAL) {
+    length--;
+  }
+  return individual::hash_genes(genome().first(length), hash_seed());
+}
 
-  auto new_rotation = data.rotate +
-                      genes[current_frame].rotate * MAX_TURN_RATE * 2 -
-                      MAX_TURN_RATE;
-  auto new_power = std::floor(data.power + genes[current_frame].power * 3) - 1;
+std::uint64_t individual_view::commands_hash(size_t from, size_t to,
+                                             std::uint64_t seed) const {
+  auto h = seed;
+  for (auto frame = from; frame < to; ++frame) {
+    const auto g = at(frame);
+    h = mix(h, static_cast<std::uint64_t>(
+                   (g.rotation_change() + MAX_TURN_RATE) * 4 +
+                   g.power_change() + 1));
+  }
+  return h;
+}
 
-  decision result{
-      .rotate = std::clamp((int)std::round(new_rotation), -MAX_ROTATION,
-                           MAX_ROTATION),
-      .power = std::clamp((int)new_power, 0, MAX_POWER),
-  };
-  ASSERT(result.rotate >= -MAX_ROTATION && result.rotate <= MAX_ROTATION);
-  ASSERT(result.power >= 0 && result.power <= MAX_POWER);
-  return result;
+std::uint64_t individual_view::hash_seed() const {
+  // Genes one tick apart keep the plain seed
+  return individual::HASH_SEED ^ ((spacing - 1) * 0x9e3779b97f4a7c15);
 }
 
-individual random_individual(const simulation_data &initial,
-                             const segment<coordinates> &landing_site) {
-  individual ind{landing_site};
-  for (auto &gene : ind.genes) {
-    gene.rotate = randf();
-    gene.power = randf();
+std::uint64_t individual::hash_genes(std::span<const gene> genes,
+                                     std::uint64_t seed) {
+  // Over the bit patterns
+  auto h = seed;
+  for (const auto &g : genes) {
+    h = mix(h, std::bit_cast<std::uint32_t>(g));
   }
-  return ind;
+  return h;
 }
 
-individual fixed_values(const simulation_data &initial, double rotate,
-                        double power,
-                        const segment<coordinates> &landing_site) {
-  individual ind{landing_site};
-  for (auto &gene : ind.genes) {
-    gene.rotate = rotate;
-    gene.power = power;
+std::vector<individual_view> population::views() const {
+  std::vector<individual_view> result;
+  result.reserve(size());
+  for (size_t i = 0; i < size(); ++i) {
+    result.push_back((*this)[i]);
   }
-  return ind;
+  return result;
 }
 
 generation random_generation(size_t size, const simulation_data &initial,
-                             const segment<coordinates> &landing_site) {
-  generation gen;
-  gen.reserve(size);
-
-  gen.push_back(fixed_values(initial, 0.5, 0.5, landing_site));
-  gen.push_back(fixed_values(initial, 0., 0., landing_site));
-  gen.push_back(fixed_values(initial, 1., 1., landing_site));
-  gen.push_back(fixed_values(initial, 1., 0., landing_site));
-  gen.push_back(fixed_values(initial, 0., 1., landing_site));
-  gen.push_back(fixed_values(initial, 1., .5, landing_site));
-  gen.push_back(fixed_values(initial, .5, 1., landing_site));
-
-  for (size_t i = gen.size(); i < size; ++i) {
-    gen.push_back(random_individual(initial, landing_site));
-  }
+                             const segment<coordinates> &landing_site,
+                             size_t length, unsigned int spacing) {
+  generation gen{size, length, landing_site};
+  gen.set_spacing(spacing);
+  randomize(gen);
   return gen;
 }
+
+void randomize(generation &gen) {
+  // A few individuals holding the same command all along
+  constexpr std::array<std::pair<double, double>, 7> FIXED{
+      {{.5, .5}, {0., 0.}, {1., 1.}, {1., 0.}, {0., 1.}, {1., .5}, {.5, 1.}}};
+  const auto size = gen.size();
+  size_t i = 0;
+  for (; i < std::min(size, FIXED.size()); ++i) {
+    std::ranges::fill(gen.genes(i),
+                      gene::from(FIXED[i].first, FIXED[i].second));
+  }
+
+  for (; i < size; ++i) {
+    for (auto &g : gen.genes(i)) {
+      const auto bits = randf.next();
+      g = {static_cast<std::uint16_t>(bits >> 48),
+           static_cast<std::uint16_t>(bits >> 32)};
+    }
+  }
+}
+
+void respace(const generation &from, generation &to, unsigned int spacing) {
+  to.set_landing_site(from.landing_site());
+  to.set_spacing(spacing);
+  to.reset(from.size(), genes_for(from.ticks(), spacing));
+  for (size_t i = 0; i < from.size(); ++i) {
+    const auto ind = from[i];
+    auto genes = to.genes(i);
+    for (size_t j = 0; j < genes.size(); ++j) {
+      genes[j] = ind.at(j * spacing);
+    }
+  }
+}
@@ -1,24 +1,139 @@
 #pragma once
 
+#include "constants.hpp"
 #include "play.hpp"
 #include "simulation.hpp"
 #include "simulation_data.hpp"
+#include "utility.hpp"
 
-#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
 
-struct individual {
-  struct gene {
-    double rotate;
-    double power;
+/// Command asked for during one tick: the change of rotation and of power,
+/// quantized on 16 bits. The decisions round them to whole degrees and
+/// power levels anyway, a double would only take four times the room.
+struct gene {
+  constexpr static inline std::uint16_t MAX = 0xffff;
+
+  std::uint16_t rotate;
+  std::uint16_t power;
+
+  /// Keeps the current rotation and power
+  static const gene NEUTRAL;
+
+  /// Gene closest to the given values between 0 and 1
+  static constexpr gene from(double rotate, double power) {
+    return {quantize(rotate), quantize(power)};
+  }
+  static constexpr std::uint16_t quantize(double value) {
+    return static_cast<std::uint16_t>(std::clamp(value, 0., 1.) * MAX + .5);
+  }
+
+  /// Values between 0 and 1
+  constexpr double rotation() const {
+    return static_cast<double>(rotate) / MAX;
+  }
+  constexpr double thrust() const { return static_cast<double>(power) / MAX; }
+
+  /// Whole degrees the decisions turn by, rotation() spread over
+  /// [-MAX_TURN_RATE, MAX_TURN_RATE] and rounded to the nearest
+  constexpr int rotation_change() const {
+    constexpr std::uint32_t RANGE = 2 * MAX_TURN_RATE;
+    return static_cast<int>((2 * RANGE * rotate + MAX) / (2 * MAX)) -
+           MAX_TURN_RATE;
+  }
+  /// Power levels the decisions add, thrust() spread over [-1, 2] and
+  /// rounded down
+  constexpr int power_change() const {
+    return static_cast<int>(3u * power / MAX) - 1;
+  }
+
+  friend bool operator==(const gene &lhs, const gene &rhs) = default;
+};
+constexpr inline gene gene::NEUTRAL = gene::from(.5, .5);
+
+/// Genes of an individual, one per tick or one every few ticks. Past the
+/// last one the lander holds its rotation and power, as if the genome went on
+/// with neutral genes.
+using genome = std::span<gene>;
+using const_genome = std::span<const gene>;
+
+/// Ticks planned for by the individuals of a first generation
+constexpr inline size_t INITIAL_HORIZON = 200;
+
+/// Genes needed to decide the first ticks when they are spacing ticks apart
+constexpr size_t genes_for(size_t ticks, unsigned int spacing) {
+  return ticks == 0 ? 0 : (ticks - 1 + spacing - 1) / spacing + 1;
+}
 
-    friend bool operator==(const gene &lhs, const gene &rhs) {
-      return lhs.rotate == rhs.rotate && lhs.power == rhs.power;
-    }
-  };
+/// Decision process of genes stored elsewhere, an individual or a row of a
+/// population. Only valid as long as they are.
+/// Genes are control points spacing ticks apart, the commands of the ticks in
+/// between are interpolated. A spacing of 1 gives each tick its own gene.
+struct individual_view {
+  const gene *genes;
+  size_t size;
+  const segment<coordinates> *landing_site;
+  unsigned int spacing = 1;
 
-  individual(const segment<coordinates> &landing_site): landing_site_(landing_site) {
+  decision operator()(const simulation_data &data,
+                      const std::vector<coordinates> &ground_line,
+                      int current_frame) const;
+
+  /// Decision knowing whether the tick would cross the landing site
+  [[nodiscard]] decision decide(const simulation_data &data,
+                                int current_frame, bool approaching) const;
+
+  /// Command of a tick, neutral past the genes
+  [[nodiscard]] gene at(size_t frame) const;
+
+  /// Ticks decided by the genes alone, the first ones of the flight
+  [[nodiscard]] size_t ticks() const {
+    return size == 0 ? 0 : (size - 1) * spacing + 1;
   }
 
+  /// Number of ticks from current_frame during which the decisions keep the
+  /// current rotation and power, assuming the lander stays away from the
+  /// ground.
+  int hold(const simulation_data &data, int current_frame) const;
+
+  [[nodiscard]] const_genome genome() const { return {genes, size}; }
+
+  /// Content hash of the genome but for its trailing neutral genes. They
+  /// decide the same commands as no gene at all, and the horizon keeps adding
+  /// and dropping them: the same flight keeps the same hash.
+  [[nodiscard]] std::uint64_t hash() const;
+
+  /// Hash of the commands of frames from to to, chained from seed. Genes the
+  /// decisions round to the same command hash the same, as do spacings giving
+  /// the same command to every frame.
+  [[nodiscard]] std::uint64_t commands_hash(size_t from, size_t to,
+                                            std::uint64_t seed) const;
+
+  /// Where the hashes of the genes start from, telling spacings apart
+  [[nodiscard]] std::uint64_t hash_seed() const;
+};
+static_assert(DecisionProcess<individual_view>,
+              "individual_view must be a DecisionProcess");
+static_assert(HoldingDecisionProcess<individual_view>,
+              "individual_view must be a HoldingDecisionProcess");
+static_assert(ApproachingDecisionProcess<individual_view>,
+              "individual_view must be an ApproachingDecisionProcess");
+
+/// Genes on their own, outside of any population
+struct individual {
+  using gene = ::gene;
+
+  individual(const segment<coordinates> &landing_site,
+             size_t length = INITIAL_HORIZON, unsigned int spacing = 1)
+      : genes(length, gene::NEUTRAL), spacing(spacing),
+        landing_site_(landing_site) {}
+  explicit individual(individual_view view)
+      : genes(view.genes, view.genes + view.size), spacing(view.spacing),
+        landing_site_(*view.landing_site) {}
+
   individual(const individual &other) = default;
   individual(individual &&other) = default;
 
@@ -27,12 +142,39 @@ struct individual {
 
   decision operator()(const simulation_data &data,
                       const std::vector<coordinates> &ground_line,
-                      int current_frame) const;
+                      int current_frame) const {
+    return view()(data, ground_line, current_frame);
+  }
+
+  [[nodiscard]] decision decide(const simulation_data &data,
+                                int current_frame, bool approaching) const {
+    return view().decide(data, current_frame, approaching);
+  }
+
+  int hold(const simulation_data &data, int current_frame) const {
+    return view().hold(data, current_frame);
+  }
+
+  std::vector<gene> genes;
+  /// Ticks between two genes
+  unsigned int spacing = 1;
+
+  constexpr static inline std::uint64_t HASH_SEED = 0xcbf29ce484222325;
+
+  /// Hash of a run of genes, chained from seed so that the hashes of
+  /// successive prefixes can be computed incrementally.
+  [[nodiscard]] static std::uint64_t
+  hash_genes(std::span<const gene> genes, std::uint64_t seed = HASH_SEED);
 
-  std::array<gene, 200> genes;
+  [[nodiscard]] std::uint64_t hash() const { return view().hash(); }
+
+  [[nodiscard]] individual_view view() const {
+    return {genes.data(), genes.size(), &landing_site_, spacing};
+  }
 
   friend bool operator==(const individual &lhs, const individual &rhs) {
-    return lhs.genes == rhs.genes && lhs.landing_site_ == rhs.landing_site_;
+    return lhs.genes == rhs.genes && lhs.spacing == rhs.spacing &&
+           lhs.landing_site_ == rhs.landing_site_;
   }
 
 private:
@@ -40,8 +182,89 @@ private:
 };
 static_assert(DecisionProcess<individual>,
               "individual must be a DecisionProcess");
+static_assert(HoldingDecisionProcess<individual>,
+              "individual must be a HoldingDecisionProcess");
+static_assert(ApproachingDecisionProcess<individual>,
+              "individual must be an ApproachingDecisionProcess");
+
+/// Genes of a whole generation in a single block, one row per individual,
+/// all of them sharing the landing site, the length of their genome and the
+/// ticks between their genes.
+/// Breeding and decoding walk through it in order.
+class population {
+public:
+  population() = default;
+  population(size_t size, size_t length,
+             const segment<coordinates> &landing_site)
+      : landing_site_{landing_site}, length_{length},
+        genes_(size * length, gene::NEUTRAL) {}
+
+  [[nodiscard]] size_t size() const {
+    return length_ == 0 ? 0 : genes_.size() / length_;
+  }
+  [[nodiscard]] bool empty() const { return genes_.empty(); }
+  /// Genes of each individual
+  [[nodiscard]] size_t length() const { return length_; }
+  /// Ticks between two genes
+  [[nodiscard]] unsigned int spacing() const { return spacing_; }
+  /// Ticks decided by the genes of each individual
+  [[nodiscard]] size_t ticks() const {
+    return length_ == 0 ? 0 : (length_ - 1) * spacing_ + 1;
+  }
+  void set_spacing(unsigned int spacing) {
+    ASSERT(spacing > 0);
+    spacing_ = spacing;
+  }
 
-using generation = std::vector<individual>;
+  /// Keeps the rows already there, the others are left to be written
+  void resize(size_t size) { genes_.resize(size * length_); }
+  /// Rows of another length, all left to be written
+  void reset(size_t size, size_t length) {
+    length_ = length;
+    genes_.resize(size * length);
+  }
+  void clear() { genes_.clear(); }
+
+  [[nodiscard]] const segment<coordinates> &landing_site() const {
+    return landing_site_;
+  }
+  void set_landing_site(const segment<coordinates> &landing_site) {
+    landing_site_ = landing_site;
+  }
+
+  [[nodiscard]] individual_view operator[](size_t i) const {
+    ASSERT(i < size());
+    return {genes_.data() + i * length_, length_, &landing_site_, spacing_};
+  }
+
+  [[nodiscard]] genome genes(size_t i) {
+    ASSERT(i < size());
+    return {genes_.data() + i * length_, length_};
+  }
+  [[nodiscard]] const_genome genes(size_t i) const {
+    return (*this)[i].genome();
+  }
+
+  /// Views of every individual, in order
+  [[nodiscard]] std::vector<individual_view> views() const;
+
+private:
+  segment<coordinates> landing_site_{{-1, -1}, {-1, -1}};
+  size_t length_{INITIAL_HORIZON};
+  unsigned int spacing_{1};
+  std::vector<gene> genes_;
+};
+
+using generation = population;
 
 generation random_generation(size_t size, const simulation_data &initial,
-                             const segment<coordinates> &landing_site);
+                             const segment<coordinates> &landing_site,
+                             size_t length = INITIAL_HORIZON,
+                             unsigned int spacing = 1);
+/// Random genes in every row, in place, a few of the first ones holding the
+/// same command all along
+void randomize(generation &gen);
+
+/// Same commands with genes spacing ticks apart over the same ticks, as close
+/// as the interpolation allows. Exact when spacing divides the former one.
+void respace(const generation &from, generation &to, unsigned int spacing);
@@ -64,7 +64,7 @@ struct generation_thread {
       } else {
         ZoneScopedN("Result Check");
         auto current = world.current_generation_name();
-        for (auto &result : world.current_generation_results()) {
+        for (auto &result : world.current_generation_summaries()) {
           if (result.final_status == simulation::status::land &&
               !world.keep_running_after_solution) {
             world.pause_generation();
@@ -151,12 +151,10 @@ int main(int argc, const char *argv[])
   // Cleanup ImGui-SFML
   ImGui::SFML::Shutdown();
 
-  randf.stop();
   return 0;
 }
 #ifdef NDEBUG
 catch (std::exception &e) {
-  randf.stop();
   std::cerr << "Error: " << e.what() << std::endl;
   return 1;
 }
@@ -1,10 +1,20 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <utility>
+#include <vector>
+
+#include "cpu_dispatch.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 template <class T>
 concept Coordinates = requires(T t) {
@@ -191,6 +201,209 @@ constexpr std::optional<T> intersection(const segment<T> &s1,
   return std::nullopt;
 }
 
+/// Segments stored as a structure of arrays, the layout read by the batched
+/// segment tests below
+struct segment_arrays {
+  std::vector<float> start_x;
+  std::vector<float> start_y;
+  std::vector<float> end_x;
+  std::vector<float> end_y;
+
+  template <Coordinates T>
+  requires std::is_same_v<coordinates_type<T>, float>
+  void push_back(const segment<T> &s) {
+    start_x.push_back(s.start.x);
+    start_y.push_back(s.start.y);
+    end_x.push_back(s.end.x);
+    end_y.push_back(s.end.y);
+  }
+
+  [[nodiscard]] size_t size() const { return start_x.size(); }
+};
+
+namespace detail {
+// Branchless versions of segments_intersect and of the hit test of
+// intersection, written once for every lane type: the scalar fallback and
+// the SSE registers. They evaluate the same float expressions in the same
+// order so every path gives the same answers.
+template <class L>
+CPU_DISPATCH_INLINE
+typename L::mask crossing(typename L::value x1, typename L::value y1,
+                          typename L::value x2, typename L::value y2,
+                          typename L::value x3, typename L::value y3,
+                          typename L::value x4, typename L::value y4) {
+  using v = typename L::value;
+  const auto area = [](v ax, v ay, v bx, v by, v cx, v cy) {
+    return L::sub(L::mul(L::sub(bx, ax), L::sub(cy, ay)),
+                  L::mul(L::sub(by, ay), L::sub(cx, ax)));
+  };
+  const auto opposite = [](v a, v b) {
+    const auto zero = L::zero();
+    return L::bit_or(L::bit_and(L::lt(a, zero), L::gt(b, zero)),
+                     L::bit_and(L::gt(a, zero), L::lt(b, zero)));
+  };
+  return L::bit_and(opposite(area(x1, y1, x2, y2, x3, y3),
+                             area(x1, y1, x2, y2, x4, y4)),
+                    opposite(area(x3, y3, x4, y4, x1, y1),
+                             area(x3, y3, x4, y4, x2, y2)));
+}
+
+template <class L>
+CPU_DISPATCH_INLINE
+typename L::mask touching(typename L::value x1, typename L::value y1,
+                          typename L::value x2, typename L::value y2,
+                          typename L::value x3, typename L::value y3,
+                          typename L::value x4, typename L::value y4) {
+  using v = typename L::value;
+  const auto denominator = L::sub(L::mul(L::sub(x1, x2), L::sub(y3, y4)),
+                                  L::mul(L::sub(y1, y2), L::sub(x3, x4)));
+  const auto t = L::sub(L::mul(L::sub(x1, x3), L::sub(y3, y4)),
+                        L::mul(L::sub(y1, y3), L::sub(x3, x4)));
+  const auto u = L::sub(L::mul(L::sub(x1, x3), L::sub(y1, y2)),
+                        L::mul(L::sub(y1, y3), L::sub(x1, x2)));
+  // n / denominator lies in [0, 1] without dividing: the quotient of floats
+  // is above 1 by more than double rounding can hide whenever |n| > |d|
+  const auto in_range = [&](v n) {
+    const auto zero = L::zero();
+    const auto same_sign =
+        L::bit_or(L::bit_and(L::gt(n, zero), L::gt(denominator, zero)),
+                  L::bit_and(L::lt(n, zero), L::lt(denominator, zero)));
+    return L::bit_or(
+        L::eq(n, zero),
+        L::bit_and(same_sign, L::le(L::abs(n), L::abs(denominator))));
+  };
+  return L::bit_and(L::neq(denominator, L::zero()),
+                    L::bit_and(in_range(t), in_range(u)));
+}
+
+struct scalar_lanes {
+  using value = float;
+  using mask = bool;
+  constexpr static inline size_t WIDTH = 1;
+
+  static value load(const float *p) { return *p; }
+  static value set(float x) { return x; }
+  static value zero() { return 0.f; }
+  static value sub(value a, value b) { return a - b; }
+  static value mul(value a, value b) { return a * b; }
+  static value abs(value a) { return std::abs(a); }
+  static mask lt(value a, value b) { return a < b; }
+  static mask gt(value a, value b) { return a > b; }
+  static mask le(value a, value b) { return a <= b; }
+  static mask eq(value a, value b) { return a == b; }
+  static mask neq(value a, value b) { return a != b; }
+  static mask bit_and(mask a, mask b) { return a & b; }
+  static mask bit_or(mask a, mask b) { return a | b; }
+  static unsigned bits(mask m) { return m; }
+};
+
+// Wider registers don't pay: the terrain hands the kernels the few segments
+// of the buckets under a motion.
+#if defined(__SSE2__)
+struct simd_lanes {
+  using value = __m128;
+  using mask = __m128;
+  constexpr static inline size_t WIDTH = 4;
+
+  static value load(const float *p) { return _mm_loadu_ps(p); }
+  static value set(float x) { return _mm_set1_ps(x); }
+  static value zero() { return _mm_setzero_ps(); }
+  static value sub(value a, value b) { return _mm_sub_ps(a, b); }
+  static value mul(value a, value b) { return _mm_mul_ps(a, b); }
+  static value abs(value a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+  static mask lt(value a, value b) { return _mm_cmplt_ps(a, b); }
+  static mask gt(value a, value b) { return _mm_cmpgt_ps(a, b); }
+  static mask le(value a, value b) { return _mm_cmple_ps(a, b); }
+  static mask eq(value a, value b) { return _mm_cmpeq_ps(a, b); }
+  static mask neq(value a, value b) { return _mm_cmpneq_ps(a, b); }
+  static mask bit_and(mask a, mask b) { return _mm_and_ps(a, b); }
+  static mask bit_or(mask a, mask b) { return _mm_or_ps(a, b); }
+  static unsigned bits(mask m) {
+    return static_cast<unsigned>(_mm_movemask_ps(m));
+  }
+};
+#else
+using simd_lanes = scalar_lanes;
+#endif
+
+// Bit i of the result tells whether test(arrays[first + i], s) holds
+template <class L, auto test, Coordinates T>
+CPU_DISPATCH_INLINE
+unsigned test_lanes(const segment_arrays &arrays, size_t first,
+                    const segment<T> &s) {
+  return L::bits(test(L::load(&arrays.start_x[first]),
+                      L::load(&arrays.start_y[first]),
+                      L::load(&arrays.end_x[first]),
+                      L::load(&arrays.end_y[first]), L::set(s.start.x),
+                      L::set(s.start.y), L::set(s.end.x), L::set(s.end.y)));
+}
+
+template <auto scalar_test, auto simd_test, Coordinates T>
+CPU_DISPATCH_INLINE
+size_t first_of(const segment_arrays &arrays, const segment<T> &s,
+                size_t from, size_t to) {
+  to = std::min(to, arrays.size());
+  auto i = from;
+  for (; i + simd_lanes::WIDTH <= to; i += simd_lanes::WIDTH) {
+    if (auto bits = test_lanes<simd_lanes, simd_test>(arrays, i, s)) {
+      return i + static_cast<size_t>(std::countr_zero(bits));
+    }
+  }
+  for (; i < to; ++i) {
+    if (test_lanes<scalar_lanes, scalar_test>(arrays, i, s)) {
+      return i;
+    }
+  }
+  return to;
+}
+} // namespace detail
+
+/// Batched segments_intersect: sets out[i] to whether arrays[i] and s cross,
+/// for every segment of the arrays
+template <Coordinates T>
+requires std::is_same_v<coordinates_type<T>, float>
+CPU_DISPATCH_INLINE
+void segments_intersect(const segment_arrays &arrays, const segment<T> &s,
+                        bool *out) {
+  using namespace detail;
+  size_t i = 0;
+  for (; i + simd_lanes::WIDTH <= arrays.size(); i += simd_lanes::WIDTH) {
+    auto bits = test_lanes<simd_lanes, crossing<simd_lanes>>(arrays, i, s);
+    for (size_t lane = 0; lane < simd_lanes::WIDTH; ++lane) {
+      out[i + lane] = (bits >> lane) & 1;
+    }
+  }
+  for (; i < arrays.size(); ++i) {
+    out[i] = test_lanes<scalar_lanes, crossing<scalar_lanes>>(arrays, i, s);
+  }
+}
+
+/// Index of the first segment of the arrays between from and to crossing s
+/// according to segments_intersect. to, or arrays.size() if smaller, if
+/// there is none.
+template <Coordinates T>
+requires std::is_same_v<coordinates_type<T>, float>
+CPU_DISPATCH_INLINE
+size_t first_crossing(const segment_arrays &arrays, const segment<T> &s,
+                      size_t from = 0, size_t to = SIZE_MAX) {
+  using namespace detail;
+  return first_of<crossing<scalar_lanes>, crossing<simd_lanes>>(arrays, s,
+                                                                from, to);
+}
+
+/// Index of the first segment of the arrays between from and to for which
+/// intersection(arrays[i], s) has a value. to, or arrays.size() if smaller,
+/// if there is none.
+template <Coordinates T>
+requires std::is_same_v<coordinates_type<T>, float>
+CPU_DISPATCH_INLINE
+size_t first_intersection(const segment_arrays &arrays, const segment<T> &s,
+                          size_t from = 0, size_t to = SIZE_MAX) {
+  using namespace detail;
+  return first_of<touching<scalar_lanes>, touching<simd_lanes>>(arrays, s,
+                                                                from, to);
+}
+
 template <Coordinates T> constexpr T midpoint(const segment<T> &s) {
   return T{(s.start.x + s.end.x) / 2, (s.start.y + s.end.y) / 2};
 }
@@ -1,2 +1,20 @@
 #include "random.hpp"
+
+#include <random>
+
+random_float::random_float() {
+#ifdef FIXED_SEED
+  seed(0);
+#else
+  std::random_device rd;
+  seed((static_cast<std::uint64_t>(rd()) << 32) | rd());
+#endif
+}
+
+void random_float::seed(std::uint64_t seed) {
+  seed_.store(seed, std::memory_order_relaxed);
+  next_stream_ = 0;
+  epoch_.fetch_add(1, std::memory_order_release);
+}
+
 random_float randf{};
@@ -1,79 +1,96 @@
 #pragma once
 #include "tracy_shim.hpp"
 
-#include <condition_variable>
-#include <cstdlib>
-#include <ctime>
-#include <random>
-#include <thread>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <span>
 
-struct random_float {
-  constexpr static inline size_t BUFFER_SIZE = 10000;
-
-  random_float() {
-#ifdef FIXED_SEED
-    // srand(0);
-#else
-    srand(time(nullptr));
-#endif
-    random_numbers = new double[BUFFER_SIZE];
-    current_number_read = random_numbers;
-    current_number_write = random_numbers;
-    while (current_number_write != random_numbers + BUFFER_SIZE) {
-      *current_number_write++ = (double)rand() / RAND_MAX;
+/// Generator owned by a single thread: xoshiro256+ seeded through
+/// splitmix64. Streams built from the same seed and different ids don't
+/// overlap in practice, which lets each chunk of a parallel loop draw from
+/// its own stream whatever thread runs it.
+struct random_stream {
+  explicit random_stream(std::uint64_t seed, std::uint64_t stream = 0) {
+    std::uint64_t x = splitmix64(seed) ^ (stream * 0xd1b54a32d192ed03);
+    for (auto &word : state_) {
+      word = splitmix64(x);
     }
+  }
 
-    random_thread = std::thread([this]() {
-      ZoneScopedN("Random thread");
-      while (true) {
-        std::unique_lock lock{write_mutex};
-        if (current_number_write == random_numbers + BUFFER_SIZE) {
-          current_number_write = random_numbers;
-          std::this_thread::sleep_for(std::chrono::microseconds(100));
-          if (stop_) {
-            return;
-          }
-        }
-        *current_number_write++ = (double)rand() / RAND_MAX;
-      }
-    });
+  std::uint64_t next() {
+    const auto result = state_[0] + state_[3];
+    const auto t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = std::rotl(state_[3], 45);
+    return result;
   }
 
-  std::random_device rd;
-  std::mt19937 gen{rd()};
+  /// Uniform in [0, 1)
+  double operator()() { return (next() >> 11) * 0x1.0p-53; }
 
-  double operator()() {
-    ZoneScopedN("Random [0,1)");
-    auto val = *current_number_read;
-    current_number_read++;
-    if (current_number_read == random_numbers + BUFFER_SIZE) {
-      current_number_read = random_numbers;
+  /// Fills out with numbers uniform in [0, 1), same as as many calls
+  void fill(std::span<double> out) {
+    for (auto &value : out) {
+      value = (*this)();
     }
-    return val;
   }
 
-  void stop() {
-    stop_ = true;
-    need_more_numbers_.notify_one();
-    if (random_thread.joinable()) {
-      random_thread.join();
-    }
+private:
+  static std::uint64_t splitmix64(std::uint64_t &x) {
+    auto z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
   }
 
-  ~random_float() {
-    stop();
-    std::unique_lock lock{write_mutex};
-    delete[] random_numbers;
+  std::array<std::uint64_t, 4> state_;
+};
+
+/// Uniform numbers for the whole program. Each thread draws from its own
+/// random_stream, created on its first draw from the current seed and the
+/// order in which the threads showed up, so there is nothing to lock. A
+/// single thread drawing after seed() always gets the same numbers.
+struct random_float {
+  random_float();
+
+  /// Uniform in [0, 1)
+  double operator()() { return local_()(); }
+
+  /// 64 random bits
+  std::uint64_t next() { return local_().next(); }
+
+  /// Fills out with numbers uniform in [0, 1), same as as many calls
+  void fill(std::span<double> out) {
+    ZoneScopedN("Random fill");
+    local_().fill(out);
   }
 
+  /// Restarts every stream from seed, threads pick it up on their next draw
+  void seed(std::uint64_t seed);
+  std::uint64_t seed() const { return seed_.load(std::memory_order_relaxed); }
+
 private:
-  double *random_numbers;
-  double *current_number_read;
-  double *current_number_write;
-  std::thread random_thread;
+  random_stream &local_() {
+    thread_local random_stream stream{0};
+    thread_local std::uint64_t epoch = 0;
+    const auto current = epoch_.load(std::memory_order_acquire);
+    if (epoch != current) {
+      stream = random_stream{seed_.load(std::memory_order_relaxed),
+                             next_stream_.fetch_add(1)};
+      epoch = current;
+    }
+    return stream;
+  }
 
-  std::mutex write_mutex;
-  std::condition_variable need_more_numbers_;
-  bool stop_;
+  std::atomic<std::uint64_t> seed_{0};
+  // Starts at 1 so that every thread seeds its stream on its first draw
+  std::atomic<std::uint64_t> epoch_{1};
+  std::atomic<std::uint64_t> next_stream_{0};
 };
 extern random_float randf;
@@ -0,0 +1,64 @@
+#include "scalar_policy.hpp"
+#include "tracy_shim.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+struct sample {
+  double x, y, vx, vy;
+};
+
+template <class P>
+std::vector<sample> replay(std::span<const simulation_data> history) {
+  using k = kinematics<P>;
+  const auto to_sample = [](const typename k::state &s) {
+    return sample{static_cast<double>(s.x), static_cast<double>(s.y),
+                  static_cast<double>(s.vx), static_cast<double>(s.vy)};
+  };
+
+  std::vector<sample> samples;
+  samples.reserve(history.size());
+  auto state = k::from(history.front());
+  samples.push_back(to_sample(state));
+  for (size_t i = 1; i < history.size(); ++i) {
+    state = k::step(state, history[i].rotate, history[i].power);
+    samples.push_back(to_sample(state));
+  }
+  return samples;
+}
+
+template <class P>
+precision_divergence compare(const char *name,
+                             std::span<const simulation_data> history,
+                             const std::vector<sample> &reference) {
+  precision_divergence result{.policy = name};
+  const auto samples = replay<P>(history);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    const auto position = std::hypot(samples[i].x - reference[i].x,
+                                      samples[i].y - reference[i].y);
+    const auto velocity = std::hypot(samples[i].vx - reference[i].vx,
+                                     samples[i].vy - reference[i].vy);
+    result.max_position_error = std::max(result.max_position_error, position);
+    result.max_velocity_error = std::max(result.max_velocity_error, velocity);
+    if (result.first_tick_off < 0 && position > 1.) {
+      result.first_tick_off = static_cast<int>(i);
+    }
+  }
+  return result;
+}
+} // namespace
+
+std::vector<precision_divergence>
+compare_precisions(std::span<const simulation_data> history) {
+  ZoneScoped;
+  if (history.empty()) {
+    return {};
+  }
+  const auto reference = replay<double_precision>(history);
+  return {
+      compare<mixed_precision>("mixed", history, reference),
+      compare<single_precision>("float", history, reference),
+      compare<fixed_precision>("fixed", history, reference),
+  };
+}
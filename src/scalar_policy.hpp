@@ -0,0 +1,160 @@
+#pragma once
+
+#include "acceleration_table.hpp"
+#include "simulation_data.hpp"
+
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// Fixed point number with 16 fractional bits. Additions are exact, every
+/// host computes the same bits.
+struct fixed_point {
+  constexpr static inline int FRACTION_BITS = 16;
+  constexpr static inline double ONE = 1 << FRACTION_BITS;
+
+  std::int64_t raw{0};
+
+  constexpr fixed_point() = default;
+  constexpr fixed_point(double x)
+      : raw{static_cast<std::int64_t>(x * ONE + (x < 0 ? -.5 : .5))} {}
+
+  [[nodiscard]] constexpr static fixed_point from_raw(std::int64_t raw) {
+    fixed_point f;
+    f.raw = raw;
+    return f;
+  }
+
+  constexpr explicit operator double() const {
+    return static_cast<double>(raw) / ONE;
+  }
+  constexpr explicit operator float() const {
+    return static_cast<float>(static_cast<double>(*this));
+  }
+
+  friend constexpr fixed_point operator+(fixed_point lhs, fixed_point rhs) {
+    return from_raw(lhs.raw + rhs.raw);
+  }
+  friend constexpr fixed_point operator-(fixed_point lhs, fixed_point rhs) {
+    return from_raw(lhs.raw - rhs.raw);
+  }
+  friend constexpr auto operator<=>(fixed_point, fixed_point) = default;
+};
+
+/// Numeric types the lander kinematics are computed with: one for the
+/// positions and velocities, one for the accelerations added to them.
+template <class Position, class Acceleration = Position> struct scalar_policy {
+  using position = Position;
+  using acceleration = Acceleration;
+};
+
+/// What simulation computes with: float state, double accelerations
+using mixed_precision = scalar_policy<float, double>;
+/// Float only, twice the lanes of double in a vector register
+using single_precision = scalar_policy<float>;
+/// The reference the others are compared to
+using double_precision = scalar_policy<double>;
+/// Same trajectories on every host and compiler
+using fixed_precision = scalar_policy<fixed_point>;
+
+/// Free flight of the lander computed with the types of a scalar policy, the
+/// tick step of both simulation engines. Collisions are checked on the state
+/// rounded to the coordinates.
+template <class P> struct kinematics {
+  using scalar = typename P::position;
+  using acceleration = typename P::acceleration;
+
+  [[nodiscard]] constexpr static scalar of(float x) {
+    return scalar(static_cast<double>(x));
+  }
+  [[nodiscard]] constexpr static float to_float(scalar x) {
+    return static_cast<float>(static_cast<double>(x));
+  }
+
+  struct state {
+    scalar x;
+    scalar y;
+    scalar vx;
+    scalar vy;
+    int fuel;
+    int rotate;
+    int power;
+  };
+
+  [[nodiscard]] constexpr static state from(const simulation_data &data) {
+    return {
+        .x = of(data.position.x),
+        .y = of(data.position.y),
+        .vx = of(data.velocity.x),
+        .vy = of(data.velocity.y),
+        .fuel = data.fuel,
+        .rotate = data.rotate,
+        .power = data.power,
+    };
+  }
+
+  [[nodiscard]] constexpr static simulation_data to_data(const state &s) {
+    return {
+        .position = {to_float(s.x), to_float(s.y)},
+        .velocity = {to_float(s.vx), to_float(s.vy)},
+        .fuel = s.fuel,
+        .rotate = s.rotate,
+        .power = s.power,
+    };
+  }
+
+  /// Applies one tick of the given command, which must already be within the
+  /// turn rate and fuel limits
+  [[nodiscard]] constexpr static state step(const state &current, int rotate,
+                                            int power) {
+    const auto a = acceleration_table::index(rotate, power);
+    return {
+        .x = current.x + current.vx,
+        .y = current.y + current.vy,
+        .vx = static_cast<scalar>(current.vx + X[a]),
+        .vy = static_cast<scalar>(current.vy + Y[a]),
+        .fuel = current.fuel - power,
+        .rotate = rotate,
+        .power = power,
+    };
+  }
+
+  /// Keeps the current rotation and power
+  [[nodiscard]] constexpr static state coast(const state &current) {
+    return step(current, current.rotate, current.power);
+  }
+
+private:
+  using table = std::array<acceleration, acceleration_table::SIZE>;
+
+  constexpr static table convert(const std::array<double, acceleration_table::SIZE> &values) {
+    table converted{};
+    for (size_t i = 0; i < values.size(); ++i) {
+      converted[i] = static_cast<acceleration>(values[i]);
+    }
+    return converted;
+  }
+
+public:
+  /// Accelerations of every command, as indexed by acceleration_table
+  constexpr static inline table X = convert(ACCELERATION.x);
+  constexpr static inline table Y = convert(ACCELERATION.y);
+};
+
+/// How far the trajectory computed with one policy drifts from the double
+/// precision one, given the same commands
+struct precision_divergence {
+  const char *policy;
+  double max_position_error{0};
+  double max_velocity_error{0};
+  /// First tick more than a meter away from the reference, -1 if none
+  int first_tick_off{-1};
+};
+
+/// Replays the commands of a trajectory, as recorded by simulation, with
+/// every scalar policy. The ground is ignored: the replays follow the
+/// commands to the last tick of the history.
+std::vector<precision_divergence>
+compare_precisions(std::span<const simulation_data> history);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "simulation_data.hpp"
+
+#include <array>
+#include <cstddef>
+
+/// Scenario known at compile time, scripts/embed_scenarios.bash generates
+/// them from scenario files
+template <size_t N> struct scenario {
+  const char *name;
+  simulation_data initial;
+  std::array<coordinates, N> ground_line;
+};
+
+template <const auto &...S> struct scenario_list {};
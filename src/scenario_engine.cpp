@@ -0,0 +1,21 @@
+#include "scenario_engine.hpp"
+#include "scenarios.hpp"
+
+#include <algorithm>
+
+namespace {
+template <const auto &...S>
+simulation::touchdown_function find(const coordinate_list &ground_line,
+                                    scenario_list<S...>) {
+  simulation::touchdown_function found = nullptr;
+  ((std::ranges::equal(ground_line, S.ground_line) &&
+    (found = &scenario_engine<S>::touchdown)) ||
+   ...);
+  return found;
+}
+} // namespace
+
+simulation::touchdown_function
+find_specialized_touchdown(const coordinate_list &ground_line) {
+  return find(ground_line, scenarios::embedded{});
+}
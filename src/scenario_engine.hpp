@@ -0,0 +1,107 @@
+#pragma once
+
+#include "constants.hpp"
+#include "cpu_dispatch.hpp"
+#include "scenario.hpp"
+#include "simulation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+/// Collision checks specialized for a scenario known at compile time. The
+/// segments, their bounding boxes, the landing site and the heights above
+/// which nothing can be hit are constants and the loop over the segments is
+/// unrolled. Gives the same results as simulation::touchdown on a terrain
+/// built from the same ground line.
+template <const auto &S> struct scenario_engine {
+  constexpr static inline size_t SEGMENTS = S.ground_line.size() - 1;
+  static_assert(SEGMENTS > 0, "A scenario needs a ground line");
+
+  constexpr static inline float CUTOFF =
+      std::ranges::max(S.ground_line, {}, &coordinates::y).y;
+
+  /// Highest ground in each of a few slices of the map, as in terrain
+  constexpr static inline size_t BUCKETS = std::max<size_t>(16, 2 * SEGMENTS);
+  constexpr static inline float BUCKET_WIDTH =
+      static_cast<float>(GAME_WIDTH) / BUCKETS;
+
+  CPU_DISPATCH static std::pair<simulation::status, simulation::crash_reason>
+  touchdown(const coordinates &start, simulation_data &next) {
+    const coordinates top_left = {std::min(start.x, next.position.x),
+                                  std::min(start.y, next.position.y)};
+    const coordinates bottom_right = {std::max(start.x, next.position.x),
+                                      std::max(start.y, next.position.y)};
+
+    std::pair result{simulation::status::none, simulation::crash_reason::none};
+    if (top_left.y > CUTOFF) {
+      return result;
+    }
+    float height = -1;
+    const auto last_bucket = bucket_index(bottom_right.x);
+    for (auto b = bucket_index(top_left.x); b <= last_bucket; ++b) {
+      height = std::max(height, HEIGHTS[b]);
+    }
+    if (top_left.y > height) {
+      return result;
+    }
+    const segment motion{start, next.position};
+    [&]<size_t... I>(std::index_sequence<I...>) {
+      (hit<I>(motion, top_left, bottom_right, next, result) || ...);
+    }(std::make_index_sequence<SEGMENTS>{});
+    return result;
+  }
+
+private:
+  constexpr static size_t bucket_index(float x) {
+    auto i = static_cast<long>(x / BUCKET_WIDTH);
+    return static_cast<size_t>(
+        std::clamp(i, 0l, static_cast<long>(BUCKETS) - 1));
+  }
+
+  constexpr static std::array<float, BUCKETS> heights() {
+    std::array<float, BUCKETS> result;
+    result.fill(-1);
+    for (size_t i = 0; i < SEGMENTS; ++i) {
+      const auto &start = S.ground_line[i];
+      const auto &end = S.ground_line[i + 1];
+      for (auto b = bucket_index(std::min(start.x, end.x));
+           b <= bucket_index(std::max(start.x, end.x)); ++b) {
+        result[b] = std::max({result[b], start.y, end.y});
+      }
+    }
+    return result;
+  }
+  constexpr static inline std::array<float, BUCKETS> HEIGHTS = heights();
+
+  template <size_t I>
+  static bool hit(const segment<coordinates> &motion,
+                  const coordinates &top_left,
+                  const coordinates &bottom_right, simulation_data &next,
+                  std::pair<simulation::status, simulation::crash_reason> &result) {
+    constexpr segment<coordinates> ground{S.ground_line[I],
+                                          S.ground_line[I + 1]};
+    constexpr coordinates min{std::min(ground.start.x, ground.end.x),
+                              std::min(ground.start.y, ground.end.y)};
+    constexpr coordinates max{std::max(ground.start.x, ground.end.x),
+                              std::max(ground.start.y, ground.end.y)};
+    constexpr bool landing_site = ground.start.y == ground.end.y;
+
+    if (max.x < top_left.x || max.y < top_left.y || min.y > bottom_right.y ||
+        min.x > bottom_right.x) {
+      return false;
+    }
+    auto inter = intersection(ground, motion);
+    if (!inter) {
+      return false;
+    }
+    next.position = *inter;
+    result = simulation::impact(landing_site, next);
+    return true;
+  }
+};
+
+/// Specialized collision check of the embedded scenario with this ground
+/// line, nullptr if there is none
+simulation::touchdown_function
+find_specialized_touchdown(const coordinate_list &ground_line);
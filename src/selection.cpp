@@ -0,0 +1,151 @@
+#include "selection.hpp"
+#include "random.hpp"
+#include "tracy_shim.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+size_t uniform_index(size_t size) {
+  return static_cast<size_t>(randf() * size);
+}
+
+void roulette(std::span<const double> scores, double total,
+              std::span<size_t> parents) {
+  for (auto &parent : parents) {
+    auto r = randf() * total;
+    parent = scores.size() - 1;
+    for (size_t i = 0; i < scores.size(); ++i) {
+      r -= scores[i];
+      if (r <= 0) {
+        parent = i;
+        break;
+      }
+    }
+  }
+}
+
+// Vose's alias method: each column holds the probability of its own index
+// and the index taking the rest of the column
+void alias(std::span<const double> scores, double total,
+           std::span<size_t> parents) {
+  const auto n = scores.size();
+  std::vector<double> probability(n);
+  std::vector<size_t> alias(n);
+  std::vector<size_t> small;
+  std::vector<size_t> large;
+  for (size_t i = 0; i < n; ++i) {
+    probability[i] = scores[i] * n / total;
+    (probability[i] < 1 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    auto s = small.back();
+    small.pop_back();
+    auto l = large.back();
+    alias[s] = l;
+    probability[l] -= 1 - probability[s];
+    if (probability[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // What is left only misses 1 by rounding errors
+  for (auto i : small) {
+    probability[i] = 1;
+  }
+  for (auto i : large) {
+    probability[i] = 1;
+  }
+
+  for (auto &parent : parents) {
+    auto column = uniform_index(n);
+    parent = randf() < probability[column] ? column : alias[column];
+  }
+}
+
+void stochastic_universal(std::span<const double> scores, double total,
+                          std::span<size_t> parents) {
+  const auto spacing = total / parents.size();
+  auto pointer = randf() * spacing;
+  double cumulated = 0;
+  size_t i = 0;
+  for (auto &parent : parents) {
+    while (i + 1 < scores.size() && cumulated + scores[i] < pointer) {
+      cumulated += scores[i++];
+    }
+    parent = i;
+    pointer += spacing;
+  }
+  // Parents come out in the order of the scores, shuffle them to pair them
+  // at random
+  for (auto j = parents.size(); j > 1; --j) {
+    std::swap(parents[j - 1], parents[uniform_index(j)]);
+  }
+}
+
+void tournament(std::span<const double> scores, unsigned size,
+                std::span<size_t> parents) {
+  for (auto &parent : parents) {
+    parent = uniform_index(scores.size());
+    for (unsigned round = 1; round < size; ++round) {
+      auto challenger = uniform_index(scores.size());
+      if (scores[challenger] > scores[parent]) {
+        parent = challenger;
+      }
+    }
+  }
+}
+} // namespace
+
+std::vector<size_t> select_parents(selection_method method,
+                                   std::span<const double> scores,
+                                   size_t count, unsigned tournament_size) {
+  ZoneScoped;
+  std::vector<size_t> parents(count);
+  if (scores.empty() || count == 0) {
+    return parents;
+  }
+  const auto total = std::accumulate(scores.begin(), scores.end(), 0.);
+  if (total <= 0 && method != selection_method::tournament) {
+    // Nothing to tell the individuals apart
+    for (auto &parent : parents) {
+      parent = uniform_index(scores.size());
+    }
+    return parents;
+  }
+
+  switch (method) {
+  case selection_method::roulette:
+    roulette(scores, total, parents);
+    break;
+  case selection_method::alias:
+    alias(scores, total, parents);
+    break;
+  case selection_method::stochastic_universal:
+    stochastic_universal(scores, total, parents);
+    break;
+  case selection_method::tournament:
+    tournament(scores, std::max(1u, tournament_size), parents);
+    break;
+  }
+  DEBUG_ONLY(for (auto parent : parents) { ASSERT(parent < scores.size()); });
+  return parents;
+}
+
+std::vector<size_t> best_indices(std::span<const double> scores,
+                                 size_t count) {
+  ZoneScoped;
+  count = std::min(count, scores.size());
+  std::vector<size_t> indices(scores.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  const auto better = [&](size_t a, size_t b) {
+    return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+  };
+  // Only the best ones need sorting
+  std::nth_element(indices.begin(), indices.begin() + count, indices.end(),
+                   better);
+  std::sort(indices.begin(), indices.begin() + count, better);
+  indices.resize(count);
+  return indices;
+}
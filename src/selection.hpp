@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+enum class selection_method {
+  /// Walks the cumulated scores for each parent, O(n) per parent
+  roulette,
+  /// Same odds as the roulette in O(1) per parent after an O(n) setup
+  alias,
+  /// One spin of a wheel with evenly spaced pointers picks every parent,
+  /// their number then stays within one of what their score is worth
+  stochastic_universal,
+  /// Best of a few individuals drawn uniformly, only the ranks matter
+  tournament,
+};
+
+/// Indices of count parents drawn among the individuals with the given
+/// scores, which can't be negative. Two consecutive parents breed together.
+std::vector<size_t> select_parents(selection_method method,
+                                   std::span<const double> scores,
+                                   size_t count, unsigned tournament_size = 2);
+
+/// Indices of the count best scores, best first. Equal scores keep their
+/// order.
+std::vector<size_t> best_indices(std::span<const double> scores, size_t count);
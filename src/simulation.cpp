@@ -1,6 +1,8 @@
 #include "simulation.hpp"
 
+#include "acceleration_table.hpp"
 #include "constants.hpp"
+#include "cpu_dispatch.hpp"
 #include "math.hpp"
 #include "tracy_shim.hpp"
 #include "utility.hpp"
@@ -15,26 +17,9 @@ simulation::tick_data simulation::simulate(const simulation_data &last_data,
                                            const input_data &input) {
   ZoneScoped;
   ASSERT(input.coords.size() > 1);
-  auto wanted_rotation =
-      std::min(MAX_ROTATION, std::max(-MAX_ROTATION, this_turn.rotate));
-  auto wanted_power = std::min(std::min(last_data.fuel, MAX_POWER),
-                               std::max(0, this_turn.power));
-
-  auto current = last_data;
-  if (auto wanted_power_change = wanted_power - current.power;
-      std::abs(wanted_power_change) > 1) {
-    wanted_power =
-        current.power + (std::abs(wanted_power_change) / wanted_power_change);
-  }
-  wanted_power = std::min(current.fuel, wanted_power);
-
-  if (auto wanted_rotation_change = wanted_rotation - current.rotate;
-      std::abs(wanted_rotation_change) > MAX_TURN_RATE) {
-    wanted_rotation =
-        current.rotate +
-        ((std::abs(wanted_rotation_change) / wanted_rotation_change) *
-         MAX_TURN_RATE);
-  }
+  auto wanted_power =
+      clamp_power(this_turn.power, last_data.power, last_data.fuel);
+  auto wanted_rotation = clamp_rotation(this_turn.rotate, last_data.rotate);
 
   auto next_tick =
       compute_next_tick(last_data, input, wanted_rotation, wanted_power);
@@ -43,81 +28,81 @@ simulation::tick_data simulation::simulate(const simulation_data &last_data,
   return next_tick;
 }
 
+namespace {
+// Inlined in each variant of step_batch along with the segment kernels. The
+// specialized checks are cloned on their own.
+CPU_DISPATCH_INLINE std::pair<simulation::status, simulation::crash_reason>
+touchdown_on(const simulation::input_data &input, const coordinates &start,
+             simulation_data &next) {
+  if (input.specialized_touchdown) {
+    return input.specialized_touchdown(start, next);
+  }
+  std::pair result{simulation::status::none, simulation::crash_reason::none};
+  const segment motion{start, next.position};
+  input.ground.find_intersection(motion, [&](size_t i) {
+    const auto &current_segment = input.ground.segment_at(i);
+    auto inter = intersection(current_segment, motion);
+    if (!inter) {
+      return false;
+    }
+    next.position = *inter;
+    result = simulation::impact(
+        current_segment.start.y == current_segment.end.y, next);
+    return true;
+  });
+  return result;
+}
+} // namespace
+
 std::pair<simulation::status, simulation::crash_reason>
 simulation::touchdown(const input_data &input, const coord_t &start,
                       simulation_data &next) {
   ZoneScoped;
-  if (next.position.y > input.y_cutoff) {
-    return {status::none, crash_reason::none};
-  }
-  coordinates top_left = {std::min(start.x, next.position.x),
-                          std::min(start.y, next.position.y)};
-  coordinates bottom_right = {std::max(start.x, next.position.x),
-                              std::max(start.y, next.position.y)};
-
-  for (size_t i = 0; i < input.coords.size() - 1; ++i) {
-    auto current_segment = segment{(input.coords)[i], (input.coords)[i + 1]};
-    auto cs_top_left =
-        coordinates{std::min(current_segment.start.x, current_segment.end.x),
-                    std::min(current_segment.start.y, current_segment.end.y)};
-    auto cs_bottom_right =
-        coordinates{std::max(current_segment.start.x, current_segment.end.x),
-                    std::max(current_segment.start.y, current_segment.end.y)};
-    if (cs_bottom_right.x < top_left.x || cs_bottom_right.y < top_left.y ||
-        cs_top_left.y > bottom_right.y) {
-      continue;
-    }
-    if (cs_top_left.x > bottom_right.x) {
-      return {status::none, crash_reason::none};
-    }
-    auto inter = intersection(current_segment, segment{start, next.position});
-    if (inter) {
-      crash_reason reason = crash_reason::none;
+  return touchdown_on(input, start, next);
+}
 
-      if (std::abs(next.velocity.x) > MAX_HORIZONTAL_SPEED) {
-        reason = static_cast<crash_reason>(reason | crash_reason::h_too_fast);
-      }
-      if (std::abs(next.velocity.y) > MAX_VERTICAL_SPEED) {
-        reason = static_cast<crash_reason>(reason | crash_reason::v_too_fast);
-      }
-      if (next.rotate != 0) {
-        reason = static_cast<crash_reason>(reason | crash_reason::rotation);
-      }
+std::pair<simulation::status, simulation::crash_reason>
+simulation::impact(bool landing_site, const simulation_data &next) {
+  crash_reason reason = crash_reason::none;
+  if (std::abs(next.velocity.x) > MAX_HORIZONTAL_SPEED) {
+    reason = static_cast<crash_reason>(reason | crash_reason::h_too_fast);
+  }
+  if (std::abs(next.velocity.y) > MAX_VERTICAL_SPEED) {
+    reason = static_cast<crash_reason>(reason | crash_reason::v_too_fast);
+  }
+  if (next.rotate != 0) {
+    reason = static_cast<crash_reason>(reason | crash_reason::rotation);
+  }
 
-      next.position = *inter;
-      if (current_segment.start.y == current_segment.end.y) {
-        if (reason != crash_reason::none) {
-          return {status::crash_on_landing_area, reason};
-        }
-
-        return {status::land, crash_reason::none};
-      } else {
-        reason =
-            static_cast<crash_reason>(reason | crash_reason::uneven_ground);
-        return {status::crash, reason};
-      }
-    }
+  if (landing_site) {
+    return {reason != crash_reason::none ? status::crash_on_landing_area
+                                         : status::land,
+            reason};
   }
-  return {status::none, crash_reason::none};
+  return {status::crash,
+          static_cast<crash_reason>(reason | crash_reason::uneven_ground)};
 }
 
 simulation::tick_data
 simulation::compute_next_tick(const simulation_data &current,
                               const input_data &input, int wanted_rotation,
                               int wanted_power) {
+  auto state = kinematics<mixed_precision>::from(current);
+  return compute_next_tick<mixed_precision>(state, input, wanted_rotation,
+                                            wanted_power);
+}
+
+template <class Policy>
+simulation::tick_data
+simulation::compute_next_tick(typename kinematics<Policy>::state &state,
+                              const input_data &input, int wanted_rotation,
+                              int wanted_power) {
   ZoneScoped;
+  using k = kinematics<Policy>;
+  const auto start = coordinates{k::to_float(state.x), k::to_float(state.y)};
+  state = k::step(state, wanted_rotation, wanted_power);
   tick_data next_data;
-  next_data.data.power = wanted_power;
-  next_data.data.fuel = current.fuel - wanted_power;
-  next_data.data.rotate = wanted_rotation;
-  next_data.data.velocity.x =
-      current.velocity.x +
-      wanted_power * (-std::sin(next_data.data.rotate * DEG_TO_RAD));
-  next_data.data.velocity.y =
-      current.velocity.y +
-      wanted_power * (std::cos(next_data.data.rotate * DEG_TO_RAD)) -
-      MARS_GRAVITY;
-  next_data.data.position = current.position + current.velocity;
+  next_data.data = k::to_data(state);
 
   if (next_data.data.position.y < 0 ||
       next_data.data.position.y > GAME_HEIGHT ||
@@ -125,9 +110,310 @@ simulation::compute_next_tick(const simulation_data &current,
     next_data.status = status::lost;
     next_data.reason = crash_reason::none;
   } else {
-    auto [status, reason] = touchdown(input, current.position, next_data.data);
+    auto [status, reason] = touchdown(input, start, next_data.data);
     next_data.status = status;
     next_data.reason = reason;
   }
   return next_data;
 }
+
+int simulation::clear_ticks(const simulation_data &data,
+                            const input_data &input, int max_ticks) {
+  ZoneScoped;
+  // Float rounding keeps the simulated positions within a fraction of a
+  // meter of the exact parabola over a whole flight
+  constexpr double MARGIN = 2.;
+
+  if (data.power > 0) {
+    max_ticks = std::min(max_ticks, data.fuel / data.power);
+  }
+  const auto acceleration = acceleration_table::index(data.rotate, data.power);
+  const double ax = ACCELERATION.x[acceleration];
+  const double ay = ACCELERATION.y[acceleration];
+
+  // Position after n ticks: p + n * v + a * n * (n - 1) / 2
+  const auto range = [](double p, double v, double a, int ticks) {
+    const auto at = [&](double n) { return p + n * v + a * n * (n - 1) / 2; };
+    auto low = std::min(p, at(ticks));
+    auto high = std::max(p, at(ticks));
+    if (a != 0) {
+      auto vertex = .5 - v / a;
+      if (vertex > 0 && vertex < ticks) {
+        low = std::min(low, at(vertex));
+        high = std::max(high, at(vertex));
+      }
+    }
+    return std::pair{low - MARGIN, high + MARGIN};
+  };
+
+  for (int ticks = max_ticks; ticks > 0; ticks /= 2) {
+    auto [min_x, max_x] = range(data.position.x, data.velocity.x, ax, ticks);
+    auto [min_y, max_y] = range(data.position.y, data.velocity.y, ay, ticks);
+    if (min_x < 0 || max_x > GAME_WIDTH || min_y < 0 || max_y > GAME_HEIGHT) {
+      continue;
+    }
+    if (min_y > input.ground.max_height(static_cast<float>(min_x),
+                                        static_cast<float>(max_x))) {
+      return ticks;
+    }
+  }
+  return 0;
+}
+
+bool simulation::doomed(const simulation_data &data, const input_data &input) {
+  ZoneScoped;
+  // Keeps the bounds on the safe side of float rounding and of the speed
+  // being checked after the last tick's acceleration
+  constexpr double SLACK = 1.;
+  // Thrust gives at most 1 m/s per unit of fuel, MAX_POWER m/s per tick and
+  // never pushes down. Each bound below integrates the best case continuously,
+  // which the per tick recurrence can only do worse than.
+  constexpr double MAX_LIFT = MAX_POWER - MARS_GRAVITY;
+  const double fuel = data.fuel;
+  const auto square = [](double x) { return x * x; };
+
+  const double fall_speed = -data.velocity.y - SLACK;
+  if (fall_speed > MAX_VERTICAL_SPEED) {
+    // Slowing down by MAX_LIFT per tick at best while gravity keeps pulling
+    const double excess = fall_speed - MAX_VERTICAL_SPEED;
+    if (fuel < excess * MAX_POWER / MAX_LIFT) {
+      return true;
+    }
+    const double braking_distance =
+        (square(fall_speed) - square(MAX_VERTICAL_SPEED)) / (2 * MAX_LIFT);
+    if (data.position.y - input.ground.min_height() < braking_distance) {
+      return true;
+    }
+  }
+
+  const double horizontal_speed = std::abs(data.velocity.x) - SLACK;
+  if (horizontal_speed > MAX_HORIZONTAL_SPEED &&
+      fuel < horizontal_speed - MAX_HORIZONTAL_SPEED) {
+    return true;
+  }
+
+  // Only gravity can stop a climb
+  const double climb_speed = data.velocity.y - SLACK;
+  if (climb_speed > 0 &&
+      GAME_HEIGHT - data.position.y < square(climb_speed) / (2 * MARS_GRAVITY)) {
+    return true;
+  }
+
+  // Flying away from the landing site towards a side of the map, without room
+  // to turn back
+  if (horizontal_speed > 0) {
+    const auto &site = input.ground.landing_site();
+    const double stopping_distance =
+        square(horizontal_speed) / (2 * MAX_POWER);
+    if (data.velocity.x > 0 && data.position.x > site.end.x &&
+        GAME_WIDTH - data.position.x < stopping_distance) {
+      return true;
+    }
+    if (data.velocity.x < 0 && data.position.x < site.start.x &&
+        data.position.x < stopping_distance) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class Policy>
+simulation::batch_data<Policy>::batch_data(std::span<const summary> starts) {
+  for (size_t i = 0; i < starts.size(); ++i) {
+    if (starts[i].final_status == status::none) {
+      index.push_back(i);
+    }
+  }
+  const auto count = index.size();
+  for (auto *v : {&position_x, &position_y, &velocity_x, &velocity_y,
+                  &previous_x, &previous_y}) {
+    v->resize(count);
+  }
+  for (auto *v : {&fuel, &rotate, &power, &wanted_rotation, &wanted_power}) {
+    v->resize(count);
+  }
+  tick_status.resize(count, status::none);
+  tick_reason.resize(count, crash_reason::none);
+  for (auto *v : {&motions.start_x, &motions.start_y, &motions.end_x,
+                  &motions.end_y}) {
+    v->resize(count);
+  }
+  approaching = std::make_unique<bool[]>(count);
+  for (size_t slot = 0; slot < count; ++slot) {
+    set(slot, starts[index[slot]].last);
+  }
+}
+
+template <class Policy>
+simulation_data simulation::batch_data<Policy>::get(size_t slot) const {
+  using k = kinematics<Policy>;
+  return {
+      .position = {k::to_float(position_x[slot]),
+                   k::to_float(position_y[slot])},
+      .velocity = {k::to_float(velocity_x[slot]),
+                   k::to_float(velocity_y[slot])},
+      .fuel = fuel[slot],
+      .rotate = rotate[slot],
+      .power = power[slot],
+  };
+}
+
+template <class Policy>
+void simulation::batch_data<Policy>::set(size_t slot,
+                                         const simulation_data &data) {
+  using k = kinematics<Policy>;
+  position_x[slot] = k::of(data.position.x);
+  position_y[slot] = k::of(data.position.y);
+  velocity_x[slot] = k::of(data.velocity.x);
+  velocity_y[slot] = k::of(data.velocity.y);
+  fuel[slot] = data.fuel;
+  rotate[slot] = data.rotate;
+  power[slot] = data.power;
+}
+
+template <class Policy> void simulation::batch_data<Policy>::coast(size_t slot) {
+  using k = kinematics<Policy>;
+  const auto acceleration = acceleration_table::index(rotate[slot], power[slot]);
+  position_x[slot] = position_x[slot] + velocity_x[slot];
+  position_y[slot] = position_y[slot] + velocity_y[slot];
+  velocity_x[slot] = static_cast<scalar>(velocity_x[slot] + k::X[acceleration]);
+  velocity_y[slot] = static_cast<scalar>(velocity_y[slot] + k::Y[acceleration]);
+  fuel[slot] -= power[slot];
+}
+
+template <class Policy> void simulation::batch_data<Policy>::compact() {
+  ZoneScoped;
+  size_t kept = 0;
+  for (size_t slot = 0; slot < size(); ++slot) {
+    if (tick_status[slot] != status::none) {
+      continue;
+    }
+    if (kept != slot) {
+      position_x[kept] = position_x[slot];
+      position_y[kept] = position_y[slot];
+      velocity_x[kept] = velocity_x[slot];
+      velocity_y[kept] = velocity_y[slot];
+      fuel[kept] = fuel[slot];
+      rotate[kept] = rotate[slot];
+      power[kept] = power[slot];
+      index[kept] = index[slot];
+    }
+    kept++;
+  }
+  // Scratch arrays are rewritten every tick, they only need to follow the size
+  for (auto *v : {&position_x, &position_y, &velocity_x, &velocity_y,
+                  &previous_x, &previous_y}) {
+    v->resize(kept);
+  }
+  for (auto *v : {&fuel, &rotate, &power, &wanted_rotation, &wanted_power}) {
+    v->resize(kept);
+  }
+  for (auto *v : {&motions.start_x, &motions.start_y, &motions.end_x,
+                  &motions.end_y}) {
+    v->resize(kept);
+  }
+  index.resize(kept);
+  tick_status.resize(kept);
+  tick_reason.resize(kept);
+}
+
+template <class Policy>
+CPU_DISPATCH void simulation::batch_data<Policy>::approach(
+    const segment<coordinates> &landing_site) {
+  ZoneScoped;
+  using k = kinematics<Policy>;
+  // From the rounded state, as the processes see it
+  for (size_t slot = 0; slot < size(); ++slot) {
+    const auto x = k::to_float(position_x[slot]);
+    const auto y = k::to_float(position_y[slot]);
+    motions.start_x[slot] = x;
+    motions.start_y[slot] = y;
+    motions.end_x[slot] = x + k::to_float(velocity_x[slot]);
+    motions.end_y[slot] = y + k::to_float(velocity_y[slot]);
+  }
+  // segments_intersect is symmetric, the landers are the arrays
+  segments_intersect(motions, landing_site, approaching.get());
+}
+
+template <class Policy>
+CPU_DISPATCH void simulation::step_batch(batch_data<Policy> &batch,
+                                         const input_data &input) {
+  ZoneScoped;
+  ASSERT(input.coords.size() > 1);
+  using k = kinematics<Policy>;
+  using scalar = typename k::scalar;
+  const size_t size = batch.size();
+
+  // Rate limits, kept free of data dependent branches so that the loop
+  // vectorizes.
+  for (size_t i = 0; i < size; ++i) {
+    const int fuel = batch.fuel[i];
+    const int power = batch.power[i];
+    const int rotate = batch.rotate[i];
+
+    int wanted_power = std::min(std::min(fuel, MAX_POWER),
+                                std::max(0, batch.wanted_power[i]));
+    wanted_power = std::min(power + 1, std::max(power - 1, wanted_power));
+    batch.wanted_power[i] = std::min(fuel, wanted_power);
+
+    int wanted_rotation = std::min(
+        MAX_ROTATION, std::max(-MAX_ROTATION, batch.wanted_rotation[i]));
+    batch.wanted_rotation[i] =
+        std::min(rotate + MAX_TURN_RATE,
+                 std::max(rotate - MAX_TURN_RATE, wanted_rotation));
+  }
+
+  // Physics, as kinematics<Policy>::step
+  for (size_t i = 0; i < size; ++i) {
+    const int wanted_power = batch.wanted_power[i];
+    const int wanted_rotation = batch.wanted_rotation[i];
+    const auto acceleration =
+        acceleration_table::index(wanted_rotation, wanted_power);
+    batch.previous_x[i] = batch.position_x[i];
+    batch.previous_y[i] = batch.position_y[i];
+    batch.position_x[i] = batch.position_x[i] + batch.velocity_x[i];
+    batch.position_y[i] = batch.position_y[i] + batch.velocity_y[i];
+    batch.velocity_x[i] =
+        static_cast<scalar>(batch.velocity_x[i] + k::X[acceleration]);
+    batch.velocity_y[i] =
+        static_cast<scalar>(batch.velocity_y[i] + k::Y[acceleration]);
+    batch.fuel[i] -= wanted_power;
+    batch.power[i] = wanted_power;
+    batch.rotate[i] = wanted_rotation;
+  }
+
+  // Out of bounds and collisions, on the rounded state
+  for (size_t i = 0; i < size; ++i) {
+    auto next = batch.get(i);
+    if (next.position.y < 0 || next.position.y > GAME_HEIGHT ||
+        next.position.x < 0 || next.position.x > GAME_WIDTH) {
+      batch.tick_status[i] = status::lost;
+      batch.tick_reason[i] = crash_reason::none;
+      continue;
+    }
+    auto [st, reason] = touchdown_on(
+        input,
+        coordinates{k::to_float(batch.previous_x[i]),
+                    k::to_float(batch.previous_y[i])},
+        next);
+    batch.tick_status[i] = st;
+    batch.tick_reason[i] = reason;
+    if (st != status::none) {
+      batch.position_x[i] = k::of(next.position.x);
+      batch.position_y[i] = k::of(next.position.y);
+    }
+  }
+}
+
+// Every policy of scalar_policy.hpp runs through both engines
+#define INSTANTIATE_POLICY(Policy)                                             \
+  template struct simulation::batch_data<Policy>;                              \
+  template void simulation::step_batch(batch_data<Policy> &,                   \
+                                       const input_data &);                    \
+  template simulation::tick_data simulation::compute_next_tick<Policy>(        \
+      kinematics<Policy>::state &, const input_data &, int, int);
+INSTANTIATE_POLICY(mixed_precision)
+INSTANTIATE_POLICY(single_precision)
+INSTANTIATE_POLICY(double_precision)
+INSTANTIATE_POLICY(fixed_precision)
+#undef INSTANTIATE_POLICY
@@ -2,9 +2,21 @@
 
 #include <cassert>
 #include <chrono>
+#include <memory>
+#include <span>
+#include <vector>
 
+#include "constants.hpp"
 #include "play.hpp"
+#include "scalar_policy.hpp"
 #include "simulation_data.hpp"
+#include "terrain.hpp"
+
+template <class F>
+concept HoldingDecisionProcess =
+    requires(const F &f, const simulation_data &data, int i) {
+      { f.hold(data, i) } -> std::convertible_to<int>;
+    };
 
 template <class F>
 concept DecisionProcess =
@@ -13,6 +25,15 @@ concept DecisionProcess =
       { f(data, ground_line, i) } -> std::same_as<decision>;
     };
 
+/// Decision process that only departs from its plan to approach the landing
+/// site of the ground, when the tick would cross it. The batch engine checks
+/// that crossing for all its landers at once and passes it along.
+template <class F>
+concept ApproachingDecisionProcess =
+    requires(const F &f, const simulation_data &data, int i, bool approaching) {
+      { f.decide(data, i, approaching) } -> std::same_as<decision>;
+    };
+
 struct simulation {
   using coord_t = ::coordinates;
   constexpr simulation() = delete;
@@ -20,7 +41,7 @@ struct simulation {
   constexpr simulation(simulation &&) = delete;
   constexpr simulation &operator=(const simulation &) = delete;
   constexpr simulation &operator=(simulation &&) = delete;
-  enum class status { none, land, crash, crash_on_landing_area, lost };
+  enum class status { none, land, crash, crash_on_landing_area, lost, doomed };
 
   enum crash_reason {
     none = 0,
@@ -38,10 +59,22 @@ struct simulation {
     simulation::crash_reason reason;
   };
 
+  /// Collision check of a motion from start to next.position, moving the
+  /// lander to the point of impact if there is one
+  using touchdown_function = std::pair<status, crash_reason> (*)(
+      const coord_t &start, simulation_data &next);
+
   struct input_data {
-    double y_cutoff;
+    const terrain &ground;
     const std::vector<coordinates> &coords;
     const simulation_data &initial_data;
+    /// Ticks between two checks for a lander that can no longer land, which
+    /// then ends where the check caught it with status::doomed.
+    /// 0 disables the checks.
+    int doomed_check_interval{0};
+    /// Collision check specialized for the ground line, see
+    /// scenario_engine.hpp. nullptr uses the generic one on ground.
+    touchdown_function specialized_touchdown{nullptr};
   };
 
   struct result {
@@ -83,8 +116,161 @@ struct simulation {
   static_assert(std::is_move_constructible_v<result>);
   static_assert(std::is_move_assignable_v<result>);
 
-  static result simulate(const input_data &coordinates,
-                         DecisionProcess auto &&process);
+  /// Outcome of a simulation without its trajectory, enough to score it.
+  /// Use simulate on the same process to get the full history back.
+  struct summary {
+    simulation_data before_last;
+    simulation_data last;
+    simulation::status final_status{simulation::status::none};
+    crash_reason reason{crash_reason::none};
+    int ticks{0};
+
+    summary() = default;
+    explicit summary(const simulation_data &initial)
+        : before_last{initial}, last{initial} {}
+    explicit summary(const result &full)
+        : before_last{full.history[full.history.size() > 1
+                                       ? full.history.size() - 2
+                                       : 0]},
+          last{full.history.back()}, final_status{full.final_status},
+          reason{full.reason},
+          ticks{static_cast<int>(full.history.size()) - 1} {}
+
+    void push(const simulation_data &data) {
+      before_last = last;
+      last = data;
+      ticks++;
+    }
+
+    [[nodiscard]] inline bool success() const {
+      return final_status == simulation::status::land;
+    }
+  };
+
+  /// Structure-of-arrays state of a set of landers advanced in lockstep by
+  /// simulate_batch. Slot i holds the lander driven by process index[i]; slots
+  /// of finished landers are compacted away after every tick.
+  /// Positions and velocities have the types of the scalar policy.
+  template <class Policy = mixed_precision> struct batch_data {
+    using scalar = typename kinematics<Policy>::scalar;
+
+    std::vector<scalar> position_x;
+    std::vector<scalar> position_y;
+    std::vector<scalar> velocity_x;
+    std::vector<scalar> velocity_y;
+    std::vector<int> fuel;
+    std::vector<int> rotate;
+    std::vector<int> power;
+    std::vector<size_t> index;
+
+    // Per tick scratch space
+    std::vector<int> wanted_rotation;
+    std::vector<int> wanted_power;
+    std::vector<scalar> previous_x;
+    std::vector<scalar> previous_y;
+    std::vector<status> tick_status;
+    std::vector<crash_reason> tick_reason;
+    segment_arrays motions;
+    std::unique_ptr<bool[]> approaching;
+
+    /// Loads the landers of the given summaries that are still flying
+    explicit batch_data(std::span<const summary> starts);
+
+    [[nodiscard]] size_t size() const { return index.size(); }
+    /// State of a lander, rounded to the coordinates
+    [[nodiscard]] simulation_data get(size_t slot) const;
+    void set(size_t slot, const simulation_data &data);
+
+    /// Advances a lander by one tick with its current rotation and power,
+    /// without any collision check. Only valid within clear_ticks of its
+    /// state.
+    void coast(size_t slot);
+
+    /// Sets approaching[slot] to whether the next tick of the lander, before
+    /// any acceleration, crosses the landing site
+    void approach(const segment<coordinates> &landing_site);
+
+    /// Removes the landers whose last tick ended the simulation, keeping the
+    /// remaining ones packed at the front of the arrays.
+    void compact();
+  };
+
+  /// Both engines compute the kinematics with the types of a scalar policy,
+  /// the histories and summaries are rounded to the coordinates. The default
+  /// is what every caller uses, the others are there to be measured against.
+  template <class Policy = mixed_precision, DecisionProcess P>
+  static result simulate(const input_data &coordinates, P &&process);
+
+  /// Simulates every process from the same initial data, one tick at a time
+  /// for the whole batch. Only the summaries are kept, they are identical to
+  /// those of calling simulate on each process individually.
+  template <class Policy = mixed_precision, DecisionProcess P>
+  static std::vector<summary> simulate_batch(const input_data &input,
+                                             std::span<const P> processes);
+
+  /// Continues the simulation of each process from its own summary, which
+  /// must come from the same input. Summaries are updated in place, those
+  /// already finished are left untouched.
+  /// on_checkpoint(i, states[i]) is called whenever lander i completes a
+  /// multiple of checkpoint_interval ticks without finishing; an interval of
+  /// 0 disables it. It may end the simulation of the lander by giving it a
+  /// final status, e.g. with an outcome known from elsewhere.
+  template <class Policy = mixed_precision, DecisionProcess P, class F>
+  static void resume_batch(const input_data &input,
+                           std::span<const P> processes,
+                           std::span<summary> states, int checkpoint_interval,
+                           F &&on_checkpoint);
+
+  /// Advances all the landers of the batch by one tick, using the decisions
+  /// stored in wanted_rotation and wanted_power.
+  template <class Policy>
+  static void step_batch(batch_data<Policy> &batch, const input_data &input);
+
+  /// Number of ticks, up to max_ticks, the lander can keep its rotation and
+  /// power without any chance of touching the ground or leaving the map.
+  /// The trajectory is a parabola while the command doesn't change: its
+  /// bounding box is computed in closed form and checked against the terrain
+  /// in one go.
+  [[nodiscard]] static int clear_ticks(const simulation_data &data,
+                                       const input_data &input, int max_ticks);
+
+  /// Whether the lander can no longer land whatever it decides next: it can't
+  /// slow down enough before reaching the ground, or can't avoid leaving the
+  /// map. Cheap bounds only, false doesn't mean a landing is possible.
+  [[nodiscard]] static bool doomed(const simulation_data &data,
+                                   const input_data &input);
+
+  /// Whether the run should be checked for doom at this frame
+  [[nodiscard]] static bool doom_check_due(const input_data &input,
+                                           size_t frame) {
+    return input.doomed_check_interval > 0 &&
+           frame % static_cast<size_t>(input.doomed_check_interval) == 0;
+  }
+
+  /// Ticks the process can be skipped for from the given state. Steps shorter
+  /// than this aren't worth the clearance check.
+  template <class P>
+  [[nodiscard]] static int coasting_ticks(const P &process,
+                                          const simulation_data &data,
+                                          const input_data &input,
+                                          int current_frame);
+
+  [[nodiscard]] static constexpr int clamp_rotation(int wanted, int current) {
+    wanted = std::min(MAX_ROTATION, std::max(-MAX_ROTATION, wanted));
+    if (auto change = wanted - current; std::abs(change) > MAX_TURN_RATE) {
+      wanted = current + ((std::abs(change) / change) * MAX_TURN_RATE);
+    }
+    return wanted;
+  }
+
+  [[nodiscard]] static constexpr int clamp_power(int wanted, int current,
+                                                 int fuel) {
+    wanted = std::min(std::min(fuel, MAX_POWER), std::max(0, wanted));
+    if (auto change = wanted - current; std::abs(change) > 1) {
+      wanted = current + (std::abs(change) / change);
+    }
+    return std::min(fuel, wanted);
+  }
 
   static tick_data simulate(const simulation_data &last_data,
                             decision this_turn, const input_data &coordinates);
@@ -94,13 +280,28 @@ struct simulation {
                     const input_data &coordinates, int from_frame,
                     int wanted_rotation);
 
+  /// Same as above with the types of a scalar policy, state is advanced in
+  /// place. The returned data is moved to the point of impact, if any.
+  template <class Policy>
+  [[nodiscard]] static tick_data
+  compute_next_tick(typename kinematics<Policy>::state &state,
+                    const input_data &coordinates, int wanted_rotation,
+                    int wanted_power);
+
   [[nodiscard]] static std::pair<status, crash_reason>
   touchdown(const input_data &coordinates, const coord_t &current,
             simulation_data &next);
+
+  /// Outcome of hitting the ground, flat on the landing site or not, in the
+  /// state given
+  [[nodiscard]] static std::pair<status, crash_reason>
+  impact(bool landing_site, const simulation_data &next);
 };
 
+template <class Policy, DecisionProcess P>
 simulation::result simulation::simulate(const input_data &input,
-                                        DecisionProcess auto &&process) {
+                                        P &&process) {
+  using k = kinematics<Policy>;
   std::vector<simulation_data> history;
   history.reserve(100);
   std::vector<decision> decision_history;
@@ -110,13 +311,39 @@ simulation::result simulation::simulate(const input_data &input,
 
   size_t current_frame = 0;
   auto last_data = input.initial_data;
+  auto state = k::from(last_data);
 
   status st = status::none;
   crash_reason reason = crash_reason::none;
   while (st == status::none) {
+    if (doom_check_due(input, current_frame) && doomed(last_data, input)) {
+      st = status::doomed;
+      break;
+    }
+    if (auto ticks =
+            coasting_ticks(process, last_data, input, current_frame);
+        ticks > 0) {
+      for (int i = 0; i < ticks && st == status::none; ++i) {
+        decision_history.push_back(
+            {.rotate = last_data.rotate, .power = last_data.power});
+        state = k::coast(state);
+        last_data = k::to_data(state);
+        history.push_back(last_data);
+        current_frame++;
+        // Checked on the same frames as when stepping
+        if (doom_check_due(input, current_frame) && doomed(last_data, input)) {
+          st = status::doomed;
+        }
+      }
+      if (st != status::none) {
+        break;
+      }
+    }
 
     auto decision = process(last_data, input.coords, current_frame);
-    auto tick = simulate(last_data, decision, input);
+    auto tick = compute_next_tick<Policy>(
+        state, input, clamp_rotation(decision.rotate, last_data.rotate),
+        clamp_power(decision.power, last_data.power, last_data.fuel));
 
     st = tick.status;
     last_data = tick.data;
@@ -137,3 +364,117 @@ simulation::result simulation::simulate(const input_data &input,
   r.reason = reason;
   return r;
 }
+
+template <class P>
+int simulation::coasting_ticks(const P &process, const simulation_data &data,
+                               const input_data &input, int current_frame) {
+  constexpr int MIN_COASTING_TICKS = 3;
+  if constexpr (HoldingDecisionProcess<P>) {
+    auto ticks = process.hold(data, current_frame);
+    if (ticks >= MIN_COASTING_TICKS) {
+      ticks = clear_ticks(data, input, ticks);
+      return ticks >= MIN_COASTING_TICKS ? ticks : 0;
+    }
+  }
+  return 0;
+}
+
+template <class Policy, DecisionProcess P>
+std::vector<simulation::summary>
+simulation::simulate_batch(const input_data &input,
+                           std::span<const P> processes) {
+  std::vector<summary> results(processes.size(), summary{input.initial_data});
+  resume_batch<Policy>(input, processes, std::span{results}, 0,
+                       [](size_t, const summary &) {});
+  return results;
+}
+
+template <class Policy, DecisionProcess P, class F>
+void simulation::resume_batch(const input_data &input,
+                              std::span<const P> processes,
+                              std::span<summary> states,
+                              int checkpoint_interval, F &&on_checkpoint) {
+  assert(processes.size() == states.size());
+  batch_data<Policy> batch{states};
+  while (batch.size() > 0) {
+    if (input.doomed_check_interval > 0) {
+      bool any_doomed = false;
+      for (size_t slot = 0; slot < batch.size(); ++slot) {
+        auto &state = states[batch.index[slot]];
+        auto is_doomed =
+            doom_check_due(input, state.ticks) && doomed(state.last, input);
+        if (is_doomed) {
+          state.final_status = status::doomed;
+          any_doomed = true;
+        }
+        batch.tick_status[slot] = is_doomed ? status::doomed : status::none;
+      }
+      if (any_doomed) {
+        batch.compact();
+        continue;
+      }
+    }
+    for (size_t slot = 0; slot < batch.size(); ++slot) {
+      auto i = batch.index[slot];
+      auto &state = states[i];
+      if (auto ticks = coasting_ticks(processes[i], state.last, input,
+                                      state.ticks);
+          ticks > 0) {
+        for (int t = 0; t < ticks && state.final_status == status::none;
+             ++t) {
+          batch.coast(slot);
+          state.push(batch.get(slot));
+          if (checkpoint_interval > 0 &&
+              state.ticks % checkpoint_interval == 0) {
+            on_checkpoint(i, state);
+          }
+          if (state.final_status == status::none &&
+              doom_check_due(input, state.ticks) &&
+              doomed(state.last, input)) {
+            state.final_status = status::doomed;
+          }
+        }
+      }
+    }
+    if constexpr (ApproachingDecisionProcess<P>) {
+      batch.approach(input.ground.landing_site());
+    }
+    for (size_t slot = 0; slot < batch.size(); ++slot) {
+      auto i = batch.index[slot];
+      const auto &state = states[i];
+      if (state.final_status != status::none) {
+        continue;
+      }
+      const auto decision = [&] {
+        if constexpr (ApproachingDecisionProcess<P>) {
+          return processes[i].decide(state.last, state.ticks,
+                                     batch.approaching[slot]);
+        } else {
+          return processes[i](state.last, input.coords, state.ticks);
+        }
+      }();
+      batch.wanted_rotation[slot] = decision.rotate;
+      batch.wanted_power[slot] = decision.power;
+    }
+
+    step_batch(batch, input);
+
+    for (size_t slot = 0; slot < batch.size(); ++slot) {
+      auto &r = states[batch.index[slot]];
+      if (r.final_status != status::none) {
+        // Ended while coasting, by on_checkpoint or as doomed
+        batch.tick_status[slot] = r.final_status;
+        continue;
+      }
+      r.push(batch.get(slot));
+      r.final_status = batch.tick_status[slot];
+      r.reason = batch.tick_reason[slot];
+      if (checkpoint_interval > 0 && r.final_status == status::none &&
+          r.ticks % checkpoint_interval == 0) {
+        on_checkpoint(batch.index[slot], r);
+        batch.tick_status[slot] = r.final_status;
+      }
+    }
+    batch.compact();
+  }
+}
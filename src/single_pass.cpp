@@ -1,15 +1,28 @@
+#include "cpu_dispatch.hpp"
 #include "genetic.hpp"
 #include "load_file.hpp"
 #include "random.hpp"
+#include "scalar_policy.hpp"
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 
 int main(int argc, const char **argv) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <file>\n";
+    std::cerr << "Usage: " << argv[0] << " <file> [screening stride]"
+                 " [perturbed scenarios] [control point spacing]"
+                 " [adaptive mutation] [mutation trace CSV]"
+                 " [adaptive crossover] [restart patience]"
+                 " [transposition table MiB]\n";
     return 1;
   }
   namespace fs = std::filesystem;
+#ifdef FIXED_SEED
+  // The library is built without it, seed here to make runs comparable
+  randf.seed(0);
+#endif
 
   const auto file_path = fs::path(argv[1]);
   if (!fs::exists(file_path)) {
@@ -27,8 +40,29 @@ int main(int argc, const char **argv) {
       .distance_weight = 1.,
       .rotation_weight = .1,
       .elite_multiplier = 5.,
-      .stdev_threshold = .1,
+      .stdev_threshold = .2,
   };
+  if (argc > 2) {
+    params.screening_stride = std::stoi(argv[2]);
+  }
+  if (argc > 3) {
+    params.perturbed_scenarios = std::stoi(argv[3]);
+  }
+  if (argc > 4) {
+    params.control_spacing = std::stoi(argv[4]);
+  }
+  if (argc > 5) {
+    params.adapt_mutation_rate = std::stoi(argv[5]) != 0;
+  }
+  if (argc > 7) {
+    params.adapt_crossover = std::stoi(argv[7]) != 0;
+  }
+  if (argc > 8) {
+    params.restart_patience = std::stoi(argv[8]);
+  }
+  if (argc > 9) {
+    params.transposition_memory = std::stoul(argv[9]) << 20;
+  }
 
   auto data = load_file(argv[1]);
 
@@ -49,7 +83,7 @@ int main(int argc, const char **argv) {
   int min_gen_n = 0;
   int max_gen_n = 0;
   ga.simulate_initial_generation(params);
-  auto vals = ga.current_generation_results();
+  auto vals = ga.current_generation_summaries();
   const auto play = [&] {
     while (1) {
       ga_data::fitness_score best_score =
@@ -74,17 +108,21 @@ int main(int argc, const char **argv) {
         max_time = dur;
       }
       ga.next_generation();
-      vals = ga.current_generation_results();
+      vals = ga.current_generation_summaries();
     }
   };
   size_t idx = play();
-  individual result = ga.current_generation()[idx];
+  individual result{ga.current_generation()[idx]};
 
   auto sec = duration_cast<seconds>(total);
   auto milli = duration_cast<milliseconds>(total % 1s);
   auto micro = duration_cast<microseconds>(total % 1ms);
   std::cout << "Found a solution in " << ga.current_generation_name()
             << " generations \n";
+  std::cout << "Kernels: " << cpu_dispatch_variant() << "\n";
+  std::cout << "Horizon: " << ga.horizon() << " ticks, "
+            << ga.current_generation().length() << " genes "
+            << ga.spacing() << " ticks apart\n";
   std::cout << "Total time: " << sec.count() << "s " << milli.count() << "ms "
             << micro.count() << "us\n";
   std::cout << "Mean generation time: "
@@ -97,5 +135,91 @@ int main(int argc, const char **argv) {
   std::cout << "Max generation time: "
             << duration_cast<microseconds>(max_time).count()
             << "us (generation: " << max_gen_n << ")\n";
-  randf.stop();
+
+  const auto stats = ga.stats();
+  const auto per_generation = [&](simulation::duration time) {
+    return duration_cast<microseconds>(time).count() /
+           ga.current_generation_name();
+  };
+  if (stats.screened > 0) {
+    std::cout << "Screening pass: " << per_generation(stats.screening_time)
+              << "us per generation, " << stats.promoted << "/"
+              << stats.screened << " promoted\n";
+  }
+  std::cout << "Exact pass: " << per_generation(stats.exact_time)
+            << "us per generation\n";
+  if (params.perturbed_scenarios > 0) {
+    std::cout << "Perturbed scenarios: " << per_generation(stats.perturbed_time)
+              << "us per generation for " << params.perturbed_scenarios
+              << " of them\n";
+  }
+  if (stats.reuse_lookups > 0) {
+    std::cout << "Reused results: " << stats.reuse_hits << "/"
+              << stats.reuse_lookups << " ("
+              << (100 * stats.reuse_hits) / stats.reuse_lookups << "%)\n";
+  }
+  if (const auto &table = stats.transpositions; table.memory > 0) {
+    const auto percent = [&](size_t n) {
+      return std::round(1000. * n / std::max<size_t>(1, table.lookups)) / 10;
+    };
+    std::cout << "Transposition table: " << table.hits << " hits ("
+              << percent(table.hits) << "%), " << table.misses << " misses ("
+              << percent(table.misses) << "%), " << table.inserts
+              << " dead ends recorded, " << (table.memory >> 10) << "KiB\n";
+  }
+  if (const auto trace = ga.mutation_trace(); !trace.empty()) {
+    double mean_rate = 0;
+    double max_rate = 0;
+    for (const auto &sample : trace) {
+      mean_rate += sample.mutation_rate / trace.size();
+      max_rate = std::max(max_rate, sample.mutation_rate);
+    }
+    const auto &last = trace.back().spread;
+    std::cout << "Mutation rate: " << mean_rate << " on average, up to "
+              << max_rate << ", last spreads " << last.fitness_spread
+              << " in scores and " << last.gene_spread << " in genes\n";
+    if (argc > 6) {
+      std::ofstream file{argv[6]};
+      file << "generation,fitness_spread,gene_spread,mutation_rate\n";
+      for (size_t i = 0; i < trace.size(); ++i) {
+        file << i + 1 << "," << trace[i].spread.fitness_spread << ","
+             << trace[i].spread.gene_spread << "," << trace[i].mutation_rate
+             << "\n";
+      }
+    }
+  }
+  for (const auto &restart : ga.restarts()) {
+    std::cout << "Restart at generation " << restart.generation
+              << ": best score " << restart.best_score << " for "
+              << restart.stalled << " generations, spreads "
+              << restart.spread.fitness_spread << " in scores and "
+              << restart.spread.gene_spread << " in genes\n";
+  }
+  const auto &crossovers = ga.crossovers();
+  for (size_t i = 0; i < crossovers.size(); ++i) {
+    const auto &op = crossovers.stats()[i];
+    std::cout << "Crossover " << crossover_operators()[i].name << ": "
+              << std::round(100 * crossovers.probabilities()[i])
+              << "% of the pairs, " << op.improvements << "/" << op.children
+              << " children better than their parents\n";
+  }
+  const auto &checkpoints = stats.checkpoints;
+  if (checkpoints.lookups > 0) {
+    auto total_ticks = checkpoints.ticks_skipped + checkpoints.ticks_simulated;
+    std::cout << "Checkpoint cache: " << checkpoints.hits << "/"
+              << checkpoints.lookups << " hits, "
+              << (100 * checkpoints.ticks_skipped) /
+                     std::max<size_t>(1, total_ticks)
+              << "% of ticks skipped\n";
+  }
+
+  const auto solution = ga.replay(idx);
+  for (const auto &d : compare_precisions(solution.history)) {
+    std::cout << "Precision " << d.policy << ": " << d.max_position_error
+              << "m, " << d.max_velocity_error << "m/s from double";
+    if (d.first_tick_off >= 0) {
+      std::cout << ", a meter off at tick " << d.first_tick_off;
+    }
+    std::cout << "\n";
+  }
 }
@@ -0,0 +1,62 @@
+#include "terrain.hpp"
+#include "constants.hpp"
+#include "tracy_shim.hpp"
+
+terrain::terrain(const coordinate_list &ground_line, size_t bucket_count) {
+  ZoneScoped;
+  if (ground_line.size() < 2) {
+    return;
+  }
+
+  segments_.reserve(ground_line.size() - 1);
+  bounds_.reserve(ground_line.size() - 1);
+  max_height_ = ground_line.front().y;
+  min_height_ = ground_line.front().y;
+  for (size_t i = 0; i + 1 < ground_line.size(); ++i) {
+    const auto &start = ground_line[i];
+    const auto &end = ground_line[i + 1];
+    segments_.push_back({start, end});
+    bounds_.push_back({
+        .min = {std::min(start.x, end.x), std::min(start.y, end.y)},
+        .max = {std::max(start.x, end.x), std::max(start.y, end.y)},
+    });
+    if (start.y == end.y) {
+      landing_site_ = {start, end};
+    }
+    max_height_ = std::max(max_height_, end.y);
+    min_height_ = std::min(min_height_, end.y);
+  }
+
+  // A couple of buckets per segment keeps the candidate lists short
+  if (bucket_count == 0) {
+    bucket_count = std::max<size_t>(16, segments_.size() * 2);
+  }
+  bucket_width_ = static_cast<float>(GAME_WIDTH) / bucket_count;
+  buckets_.assign(bucket_count, bucket{.max_height = -1, .first = 0, .count = 0});
+
+  for (const auto &box : bounds_) {
+    for (auto b = bucket_index_(box.min.x); b <= bucket_index_(box.max.x);
+         ++b) {
+      buckets_[b].count++;
+      buckets_[b].max_height = std::max(buckets_[b].max_height, box.max.y);
+    }
+  }
+
+  std::uint32_t offset = 0;
+  for (auto &b : buckets_) {
+    b.first = offset;
+    offset += b.count;
+    b.count = 0;
+  }
+
+  bucket_segments_.resize(offset);
+  for (std::uint32_t i = 0; i < bounds_.size(); ++i) {
+    for (auto b = bucket_index_(bounds_[i].min.x);
+         b <= bucket_index_(bounds_[i].max.x); ++b) {
+      bucket_segments_[buckets_[b].first + buckets_[b].count++] = i;
+    }
+  }
+  for (auto i : bucket_segments_) {
+    bucket_columns_.push_back(segments_[i]);
+  }
+}
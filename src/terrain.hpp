@@ -0,0 +1,114 @@
+#pragma once
+
+#include "cpu_dispatch.hpp"
+#include "simulation_data.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// Precomputed view of the ground line, built once per scenario. Segments are
+/// bucketed by x so that collision checks only look at the few segments under
+/// the lander instead of scanning the whole line.
+struct terrain {
+  struct bounding_box {
+    coordinates min;
+    coordinates max;
+  };
+
+  terrain() = default;
+  explicit terrain(const coordinate_list &ground_line, size_t bucket_count = 0);
+
+  [[nodiscard]] const segment<coordinates> &landing_site() const {
+    return landing_site_;
+  }
+
+  /// Highest point of the whole ground line
+  [[nodiscard]] float max_height() const { return max_height_; }
+
+  /// Lowest point of the whole ground line
+  [[nodiscard]] float min_height() const { return min_height_; }
+
+  /// Upper bound of the ground height between min_x and max_x
+  [[nodiscard]] float max_height(float min_x, float max_x) const {
+    float height = -1;
+    const auto last_bucket = bucket_index_(max_x);
+    for (auto b = bucket_index_(min_x); b <= last_bucket; ++b) {
+      height = std::max(height, buckets_[b].max_height);
+    }
+    return height;
+  }
+
+  [[nodiscard]] size_t segment_count() const { return segments_.size(); }
+  [[nodiscard]] const segment<coordinates> &segment_at(size_t i) const {
+    return segments_[i];
+  }
+  [[nodiscard]] const bounding_box &bounds_at(size_t i) const {
+    return bounds_[i];
+  }
+  /// Calls f(index) for every segment the motion touches according to
+  /// intersection, in ground line order, stopping as soon as f returns true.
+  /// Only the segments of the buckets under the motion go through the
+  /// batched test. Returns whether f returned true.
+  template <class F>
+  CPU_DISPATCH_INLINE bool find_intersection(const segment<coordinates> &motion,
+                                             F &&f) const;
+
+private:
+  struct bucket {
+    float max_height;
+    std::uint32_t first;
+    std::uint32_t count;
+  };
+
+  std::vector<segment<coordinates>> segments_;
+  std::vector<bounding_box> bounds_;
+  std::vector<bucket> buckets_;
+  std::vector<std::uint32_t> bucket_segments_;
+  // Segments of bucket_segments_, the candidates of consecutive buckets are
+  // contiguous
+  segment_arrays bucket_columns_;
+  float bucket_width_{1};
+  float max_height_{0};
+  float min_height_{0};
+  segment<coordinates> landing_site_{{-1, -1}, {-1, -1}};
+
+  [[nodiscard]] size_t bucket_index_(float x) const {
+    auto i = static_cast<long>(x / bucket_width_);
+    return static_cast<size_t>(
+        std::clamp(i, 0l, static_cast<long>(buckets_.size()) - 1));
+  }
+};
+
+template <class F>
+bool terrain::find_intersection(const segment<coordinates> &motion,
+                                F &&f) const {
+  const coordinates min{std::min(motion.start.x, motion.end.x),
+                        std::min(motion.start.y, motion.end.y)};
+  const coordinates max{std::max(motion.start.x, motion.end.x),
+                        std::max(motion.start.y, motion.end.y)};
+  if (buckets_.empty() || min.y > max_height(min.x, max.x)) {
+    return false;
+  }
+  const auto &first = buckets_[bucket_index_(min.x)];
+  const auto &last = buckets_[bucket_index_(max.x)];
+  const size_t to = last.first + last.count;
+  // Segments spanning several buckets are listed in each of them
+  long last_tested = -1;
+  for (auto i = first_intersection(bucket_columns_, motion, first.first, to);
+       i < to; i = first_intersection(bucket_columns_, motion, i + 1, to)) {
+    auto index = bucket_segments_[i];
+    if (static_cast<long>(index) <= last_tested) {
+      continue;
+    }
+    last_tested = index;
+    const auto &box = bounds_[index];
+    if (box.max.x < min.x || box.max.y < min.y || box.min.y > max.y ||
+        box.min.x > max.x) {
+      continue;
+    }
+    if (f(static_cast<size_t>(index))) {
+      return true;
+    }
+  }
+  return false;
+}
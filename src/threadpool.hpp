@@ -9,10 +9,8 @@
 #include <thread>
 #include <vector>
 
-#include "simulation.hpp"
-
 struct thread_pool {
-  using task = std::packaged_task<simulation::result()>;
+  using task = std::packaged_task<void()>;
 
   thread_pool(size_t threads = std::thread::hardware_concurrency())
       : threads_{} {
@@ -47,6 +45,8 @@ struct thread_pool {
     }
   }
 
+  size_t size() const { return threads_.size(); }
+
   template <class T>
   requires std::convertible_to<std::decay_t<T>, task>
   void push(T &&t) {
@@ -0,0 +1,120 @@
+#include "transposition_table.hpp"
+#include "tracy_shim.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+void transposition_table::resize(size_t memory) {
+  slot_count_ = memory >= sizeof(slot) ? std::bit_floor(memory / sizeof(slot))
+                                       : 0;
+  slots_ = slot_count_ > 0 ? std::make_unique<slot[]>(slot_count_) : nullptr;
+  lookups_ = 0;
+  hits_ = 0;
+  inserts_ = 0;
+}
+
+bool transposition_table::dead_end(const simulation::summary &outcome) {
+  switch (outcome.final_status) {
+  case simulation::status::crash:
+  case simulation::status::crash_on_landing_area:
+  case simulation::status::lost:
+  case simulation::status::doomed:
+    return true;
+  case simulation::status::none:
+  case simulation::status::land:
+    return false;
+  }
+  return false;
+}
+
+transposition_table::key
+transposition_table::make_key(const simulation_data &data, int frame) {
+  const auto mix = [](std::uint64_t h, std::int64_t x) {
+    h = (h ^ static_cast<std::uint64_t>(x)) * 0x9e3779b97f4a7c15;
+    return h ^ (h >> 32);
+  };
+  auto h = mix(0xcbf29ce484222325, frame);
+  h = mix(h, std::lround(data.position.x / POSITION_STEP));
+  h = mix(h, std::lround(data.position.y / POSITION_STEP));
+  h = mix(h, std::lround(data.velocity.x / VELOCITY_STEP));
+  h = mix(h, std::lround(data.velocity.y / VELOCITY_STEP));
+  h = mix(h, data.fuel / FUEL_STEP);
+  h = mix(h, data.rotate);
+  h = mix(h, data.power);
+  // 0 marks the empty slots
+  return h | 1;
+}
+
+std::optional<transposition_table::entry>
+transposition_table::find(key k, const simulation::summary &from) const {
+  ZoneScoped;
+  if (!enabled()) {
+    return std::nullopt;
+  }
+  lookups_.fetch_add(1, std::memory_order_relaxed);
+  auto &s = slot_of_(k);
+
+  auto before = s.sequence.load(std::memory_order_acquire);
+  if (before & 1) {
+    return std::nullopt;
+  }
+  auto tag = s.tag.load(std::memory_order_relaxed);
+  std::array<std::uint64_t, WORDS> words;
+  for (size_t i = 0; i < WORDS; ++i) {
+    words[i] = s.value[i].load(std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (s.sequence.load(std::memory_order_relaxed) != before || tag != k) {
+    return std::nullopt;
+  }
+
+  bytes raw;
+  std::memcpy(raw.data(), words.data(), raw.size());
+  auto e = std::bit_cast<entry>(raw);
+  // Stored relative to the key
+  e.outcome.ticks += from.ticks;
+  return e;
+}
+
+void transposition_table::insert(key k, int from_ticks, const entry &e) {
+  ZoneScoped;
+  if (!enabled() || !dead_end(e.outcome)) {
+    return;
+  }
+  auto &s = slot_of_(k);
+  auto sequence = s.sequence.load(std::memory_order_relaxed);
+  if ((sequence & 1) ||
+      !s.sequence.compare_exchange_strong(sequence, sequence + 1,
+                                          std::memory_order_acquire)) {
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto relative = e;
+  relative.outcome.ticks -= from_ticks;
+  const auto raw = std::bit_cast<bytes>(relative);
+  std::array<std::uint64_t, WORDS> words{};
+  std::memcpy(words.data(), raw.data(), raw.size());
+  s.tag.store(k, std::memory_order_relaxed);
+  for (size_t i = 0; i < WORDS; ++i) {
+    s.value[i].store(words[i], std::memory_order_relaxed);
+  }
+  s.sequence.store(sequence + 2, std::memory_order_release);
+  inserts_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void transposition_table::clear() { resize(memory()); }
+
+transposition_table::statistics transposition_table::stats() const {
+  const auto lookups = lookups_.load(std::memory_order_relaxed);
+  const auto hits = hits_.load(std::memory_order_relaxed);
+  return {
+      .lookups = lookups,
+      .hits = hits,
+      .misses = lookups - std::min(hits, lookups),
+      .inserts = inserts_.load(std::memory_order_relaxed),
+      .memory = memory(),
+  };
+}
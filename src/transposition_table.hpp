@@ -0,0 +1,106 @@
+#pragma once
+
+#include "simulation.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/// Decision process able to hash the commands it gives between two frames
+template <class P>
+concept SuffixHashedProcess =
+    requires(const P &p, size_t from, size_t to, std::uint64_t seed) {
+      { p.commands_hash(from, to, seed) } -> std::convertible_to<std::uint64_t>;
+    };
+
+/// Dead ends of simulations keyed by a quantized state and the frame it was
+/// reached at. Different genomes often drive the lander through nearly the
+/// same states, once one of them has crashed, been lost or been found doomed
+/// from there, the others can take its outcome if they would give the same
+/// commands until then: each outcome comes with the hash of the commands that
+/// led to it. States within a grid cell count as equal, so outcomes are
+/// approximations. Only dead ends are recorded, an approximate outcome is
+/// never taken for a landing.
+///
+/// The table has a fixed size and is shared by the worker threads without
+/// locks: each slot is a seqlock, a writer finding it busy gives up and a
+/// reader catching it mid-write misses. Colliding entries overwrite each other.
+/// Outcomes are only valid for the scenario they were recorded on.
+struct transposition_table {
+  using key = std::uint64_t;
+
+  // Grid the states are snapped to
+  constexpr static inline float POSITION_STEP = 1.f;
+  constexpr static inline float VELOCITY_STEP = .5f;
+  constexpr static inline int FUEL_STEP = 5;
+
+  struct statistics {
+    size_t lookups{0};
+    size_t hits{0};
+    size_t misses{0};
+    size_t inserts{0};
+    size_t memory{0};
+  };
+
+  explicit transposition_table(size_t memory = 0) { resize(memory); }
+
+  /// Reallocates the table within the given number of bytes, 0 disables it.
+  /// Not thread safe.
+  void resize(size_t memory);
+
+  [[nodiscard]] bool enabled() const { return slot_count_ > 0; }
+  [[nodiscard]] size_t memory() const { return slot_count_ * sizeof(slot); }
+
+  struct entry {
+    simulation::summary outcome;
+    /// Hash of the commands from the state of the key to the outcome
+    std::uint64_t commands;
+  };
+
+  /// Whether the outcome can be recorded: a simulation that went through the
+  /// same state can't land
+  [[nodiscard]] static bool dead_end(const simulation::summary &outcome);
+
+  [[nodiscard]] static key make_key(const simulation_data &data, int frame);
+
+  /// Outcome recorded from the given state, if any. It only applies to a
+  /// process whose commands hash to the same value up to the outcome.
+  [[nodiscard]] std::optional<entry> find(key k,
+                                          const simulation::summary &from) const;
+
+  /// Records the dead end reached by a simulation that went through the key
+  /// at from_ticks, other outcomes are ignored
+  void insert(key k, int from_ticks, const entry &e);
+
+  /// Marks a found entry as used by the caller
+  void count_hit() { hits_.fetch_add(1, std::memory_order_relaxed); }
+
+  /// Not thread safe
+  void clear();
+
+  [[nodiscard]] statistics stats() const;
+
+private:
+  static_assert(std::is_trivially_copyable_v<entry>);
+  constexpr static inline size_t WORDS =
+      (sizeof(entry) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+  using bytes = std::array<std::byte, sizeof(entry)>;
+
+  struct slot {
+    std::atomic<std::uint32_t> sequence{0};
+    std::atomic<key> tag{0};
+    std::array<std::atomic<std::uint64_t>, WORDS> value{};
+  };
+
+  std::unique_ptr<slot[]> slots_;
+  size_t slot_count_{0};
+  mutable std::atomic<size_t> lookups_{0};
+  mutable std::atomic<size_t> hits_{0};
+  std::atomic<size_t> inserts_{0};
+
+  [[nodiscard]] slot &slot_of_(key k) const {
+    return slots_[k & (slot_count_ - 1)];
+  }
+};
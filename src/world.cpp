@@ -129,6 +129,8 @@ void world_data::save_params() {
   file << ga_params.rotation_weight << '\n';
   file << ga_params.elite_multiplier << '\n';
   file << ga_params.stdev_threshold << '\n';
+  file << static_cast<int>(ga_params.selection) << '\n';
+  file << ga_params.tournament_size << '\n';
 }
 
 void world_data::load_params() {
@@ -152,4 +154,9 @@ void world_data::load_params() {
   file >> ga_params.rotation_weight;
   file >> ga_params.elite_multiplier;
   file >> ga_params.stdev_threshold;
+  // Missing from files saved before they were added
+  if (int selection; file >> selection) {
+    ga_params.selection = static_cast<selection_method>(selection);
+    file >> ga_params.tournament_size;
+  }
 }
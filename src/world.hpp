@@ -33,7 +33,10 @@ struct world_data : sf::Drawable {
     reset_individual_selection_();
   }
   void pause_generation() { generating_ = false; }
-  void sort_generation_results() { ga.sort_generation_results(); }
+  void sort_generation_results() {
+    last_selected_.reset();
+    ga.sort_generation_results();
+  }
 
   bool generating() const { return generating_; }
   bool generated() const { return has_values() && !generating_; }
@@ -49,16 +52,22 @@ struct world_data : sf::Drawable {
     return ga.current_generation_results();
   }
 
+  ga_data::generation_summary current_generation_summaries() const {
+    return ga.current_generation_summaries();
+  }
+
   size_t generation_size() const { return ga.generation_size(); }
 
   void next_generation() {
     selected_individual.reset();
+    last_selected_.reset();
     ga.next_generation();
   }
 
   void new_generation() {
     assert(!generating_);
     selected_individual = std::nullopt;
+    last_selected_.reset();
     ga.simulate_initial_generation(ga_params);
   }
 
@@ -68,16 +77,14 @@ struct world_data : sf::Drawable {
     assert(loaded_.ground_line.size() > 0);
     assert(!generating_);
 
-    auto currently_selected =
-        ga.current_generation_results()[*selected_individual];
-
     if (!game || last_selected_ != selected_individual) {
       last_selected_ = selected_individual;
-      game.emplace(transform, currently_selected, loaded_.ground_line);
+      game.emplace(transform, ga.replay(*selected_individual),
+                   loaded_.ground_line);
       lander.attach(*game);
     }
 
-    return currently_selected;
+    return game->result();
   }
 
   segment<coordinates> landing_site() const {
@@ -0,0 +1,150 @@
+#include "breeding.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+
+TEST_CASE("Breeding operators") {
+  const segment<coordinates> landing_site{{0, 0}, {1000, 0}};
+  randf.seed(1);
+  random_stream random{1};
+  const auto parents = random_generation(10, {}, landing_site);
+  population children{2, parents.length(), landing_site};
+  // Past the individuals with fixed values
+  const auto p1 = parents.genes(8);
+  const auto p2 = parents.genes(9);
+  const auto child1 = children.genes(0);
+  const auto child2 = children.genes(1);
+
+  SECTION("Quantization") {
+    REQUIRE(gene::from(0., 1.) == gene{0, gene::MAX});
+    REQUIRE(gene::from(-1., 2.) == gene{0, gene::MAX});
+    REQUIRE(gene::from(.5, .25).rotation() == Catch::Approx(.5).margin(1e-4));
+    REQUIRE(gene::from(.5, .25).thrust() == Catch::Approx(.25).margin(1e-4));
+  }
+
+  SECTION("Linear interpolation") {
+    crossover_linear_interpolation(p1, p2, child1, child2, random);
+    const auto between = [](int value, int a, int b) {
+      // Rounded down twice
+      return value >= std::min(a, b) - 2 && value <= std::max(a, b);
+    };
+    for (size_t i = 0; i < p1.size(); ++i) {
+      const auto &[a, b, c, d] = std::tie(p1[i], p2[i], child1[i], child2[i]);
+      REQUIRE(between(c.rotate, a.rotate, b.rotate));
+      REQUIRE(between(c.power, a.power, b.power));
+      REQUIRE(between(d.rotate, a.rotate, b.rotate));
+      REQUIRE(between(d.power, a.power, b.power));
+      // Four roundings and weights adding up to 65535 / 65536
+      REQUIRE(std::abs(c.rotate + d.rotate - a.rotate - b.rotate) <= 5);
+      REQUIRE(std::abs(c.power + d.power - a.power - b.power) <= 5);
+    }
+  }
+
+  SECTION("Random selection") {
+    crossover_random_selection(p1, p2, child1, child2, random);
+    size_t from_first = 0;
+    for (size_t i = 0; i < p1.size(); ++i) {
+      const bool straight = child1[i] == p1[i] && child2[i] == p2[i];
+      const bool swapped = child1[i] == p2[i] && child2[i] == p1[i];
+      REQUIRE((straight || swapped));
+      from_first += straight;
+    }
+    REQUIRE(from_first > p1.size() / 4);
+    REQUIRE(from_first < 3 * p1.size() / 4);
+  }
+
+  SECTION("Alternate") {
+    crossover_alternate(p1, p2, child1, child2, random);
+    for (size_t i = 0; i < p1.size(); ++i) {
+      REQUIRE(child1[i] == (i % 2 == 0 ? p1 : p2)[i]);
+      REQUIRE(child2[i] == (i % 2 == 0 ? p2 : p1)[i]);
+    }
+  }
+
+  SECTION("Mutation") {
+    const auto mutations = [&](double rate) {
+      std::ranges::copy(p1, child1.begin());
+      mutate(child1, rate, random);
+      size_t count = 0;
+      for (size_t i = 0; i < p1.size(); ++i) {
+        count += child1[i].rotate != p1[i].rotate;
+        count += child1[i].power != p1[i].power;
+      }
+      return count;
+    };
+    REQUIRE(mutations(0) == 0);
+    // A redrawn value can be the same
+    REQUIRE(mutations(1) >= 2 * p1.size() - 2);
+
+    constexpr int RUNS = 2000;
+    size_t total = 0;
+    for (int run = 0; run < RUNS; ++run) {
+      total += mutations(.02);
+    }
+    const double rate = static_cast<double>(total) / (RUNS * 2 * p1.size());
+    REQUIRE(rate == Catch::Approx(.02).margin(.002));
+  }
+}
+
+TEST_CASE("Population") {
+  const segment<coordinates> landing_site{{0, 0}, {1000, 0}};
+  const auto gen = random_generation(20, {}, landing_site);
+  REQUIRE(gen.size() == 20);
+  REQUIRE(gen.landing_site() == landing_site);
+
+  // Rows follow each other
+  REQUIRE(gen[1].genes == gen[0].genes + gen.length());
+  REQUIRE(*gen[3].landing_site == landing_site);
+
+  const individual copy{gen[12]};
+  REQUIRE(std::ranges::equal(copy.genes, gen.genes(12)));
+  REQUIRE(copy.hash() == gen[12].hash());
+  REQUIRE(copy.hash() != gen[13].hash());
+
+  // Trailing neutral genes fly the same as no genes
+  auto longer = copy;
+  longer.genes.resize(copy.genes.size() + 10, gene::NEUTRAL);
+  REQUIRE(longer.hash() == copy.hash());
+  longer.genes.back() = gene::from(0., 1.);
+  REQUIRE(longer.hash() != copy.hash());
+
+  auto resized = gen;
+  resized.resize(25);
+  REQUIRE(resized.size() == 25);
+  REQUIRE(std::ranges::equal(resized.genes(19), gen.genes(19)));
+
+  resized.reset(30, 50);
+  REQUIRE(resized.size() == 30);
+  REQUIRE(resized.length() == 50);
+  REQUIRE(resized[29].genome().size() == 50);
+}
+
+TEST_CASE("Breeding genomes of any length") {
+  const segment<coordinates> landing_site{{0, 0}, {1000, 0}};
+  random_stream random{2};
+  // Not a whole number of registers
+  const auto parents = random_generation(10, {}, landing_site, 70);
+  population children{2, parents.length(), landing_site};
+  const auto p1 = parents.genes(8);
+  const auto p2 = parents.genes(9);
+  const auto child1 = children.genes(0);
+  const auto child2 = children.genes(1);
+
+  crossover_random_selection(p1, p2, child1, child2, random);
+  for (size_t i = 0; i < p1.size(); ++i) {
+    REQUIRE(((child1[i] == p1[i] && child2[i] == p2[i]) ||
+             (child1[i] == p2[i] && child2[i] == p1[i])));
+  }
+  crossover_linear_interpolation(p1, p2, child1, child2, random);
+  for (size_t i = 0; i < p1.size(); ++i) {
+    REQUIRE(child1[i].rotate >= std::min(p1[i].rotate, p2[i].rotate) - 2);
+    REQUIRE(child1[i].rotate <= std::max(p1[i].rotate, p2[i].rotate));
+  }
+  crossover_alternate(p1, p2, child1, child2, random);
+  REQUIRE(child1.back() == p2.back());
+  REQUIRE(child2.back() == p1.back());
+
+  std::ranges::copy(p1, child1.begin());
+  mutate(child1, 1, random);
+  REQUIRE(child1.back() != p1.back());
+}
@@ -0,0 +1,59 @@
+#include "breeding.hpp"
+#include "crossover_bandit.hpp"
+#include "random.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+TEST_CASE("Crossover bandit") {
+  randf.seed(4);
+  crossover_bandit bandit{3};
+  for (auto p : bandit.probabilities()) {
+    REQUIRE(p == Catch::Approx(1. / 3));
+  }
+
+  // The second operator improves on its parents far more often
+  for (int generation = 0; generation < 30; ++generation) {
+    for (int child = 0; child < 20; ++child) {
+      bandit.reward(0, child < 1);
+      bandit.reward(1, child < 8);
+      bandit.reward(2, false);
+    }
+    bandit.update();
+  }
+  const auto p = bandit.probabilities();
+  REQUIRE(p[1] > p[0]);
+  REQUIRE(p[0] > p[2]);
+  // Out of favour, not out of the running
+  REQUIRE(p[2] == Catch::Approx(.1));
+  REQUIRE(p[0] + p[1] + p[2] == Catch::Approx(1));
+  REQUIRE(bandit.stats()[1].children == 600);
+  REQUIRE(bandit.stats()[1].improvements == 240);
+
+  std::vector<size_t> choices(30000);
+  bandit.draw(choices);
+  for (size_t op = 0; op < 3; ++op) {
+    const auto share =
+        static_cast<double>(std::ranges::count(choices, op)) / choices.size();
+    REQUIRE(share == Catch::Approx(p[op]).margin(.01));
+  }
+}
+
+TEST_CASE("Crossover registry") {
+  const auto builtin = crossover_operators().size();
+  REQUIRE(builtin >= 3);
+  REQUIRE(std::string{crossover_operators()[0].name} == "linear interpolation");
+
+  // Children as copies of their parents
+  const auto index = register_crossover(
+      {"copy", [](const_genome p1, const_genome p2, genome child1,
+                  genome child2, random_stream &) {
+         std::ranges::copy(p1, child1.begin());
+         std::ranges::copy(p2, child2.begin());
+       }});
+  REQUIRE(index == builtin);
+  REQUIRE(crossover_operators().size() == builtin + 1);
+  REQUIRE(std::string{crossover_operators()[index].name} == "copy");
+}
@@ -0,0 +1,121 @@
+#include "diversity.hpp"
+#include "genetic.hpp"
+#include "random.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <vector>
+
+TEST_CASE("Diversity") {
+  const segment<coordinates> landing_site{{0, 0}, {1000, 0}};
+  random_stream random{3};
+  population gen{200, 50, landing_site};
+  // Random genes past the first 10, which all individuals share
+  for (size_t i = 0; i < gen.size(); ++i) {
+    auto genes = gen.genes(i);
+    for (size_t j = 10; j < genes.size(); ++j) {
+      const auto bits = random.next();
+      genes[j] = {static_cast<std::uint16_t>(bits >> 48),
+                  static_cast<std::uint16_t>(bits >> 32)};
+    }
+  }
+  std::vector<double> scores(gen.size(), 5.);
+
+  auto d = measure_diversity(gen, scores, 10);
+  REQUIRE(d.fitness_spread == 0);
+  REQUIRE(d.gene_spread == 0);
+
+  scores[0] = 6;
+  scores[1] = 4;
+  d = measure_diversity(gen, scores, gen.length());
+  // Two outliers out of 200
+  REQUIRE(d.fitness_spread == Catch::Approx(.05));
+  REQUIRE(d.gene_spread == Catch::Approx(std::sqrt(.8)).margin(.05));
+
+  // Summed up in chunks as the rows get written, the same as in one pass
+  gene_moments first;
+  gene_moments second;
+  first.reset(gen.length());
+  second.reset(gen.length());
+  for (size_t i = 0; i < gen.size(); ++i) {
+    (i < 64 ? first : second).add(gen.genes(i));
+  }
+  first.merge(second);
+  REQUIRE(first.count() == gen.size());
+  const auto merged = measure_diversity(first, scores, gen.length());
+  REQUIRE(merged.fitness_spread == d.fitness_spread);
+  REQUIRE(merged.gene_spread == d.gene_spread);
+  REQUIRE(first.spread(10) == 0);
+}
+
+TEST_CASE("Adaptive mutation rate") {
+  adaptive_mutation mutation;
+  const diversity converged{.fitness_spread = .01, .gene_spread = .05};
+  const diversity diverse{.fitness_spread = .3, .gene_spread = .8};
+  const diversity on_target{.fitness_spread = .2, .gene_spread = .4};
+
+  // Under the base rate while more diverse than the targets
+  double rate = mutation.update(.01, diverse, .2, .4);
+  REQUIRE(rate < .01);
+  for (int i = 0; i < 3; ++i) {
+    const auto next = mutation.update(.01, converged, .2, .4);
+    REQUIRE(next > rate);
+    rate = next;
+  }
+  for (int i = 0; i < 20; ++i) {
+    rate = mutation.update(.01, converged, .2, .4);
+  }
+  // Bounded
+  REQUIRE(rate <= .25);
+  REQUIRE(rate == Catch::Approx(.1));
+
+  for (int i = 0; i < 20; ++i) {
+    rate = mutation.update(.01, on_target, .2, .4);
+  }
+  REQUIRE(rate == Catch::Approx(.01).epsilon(.01));
+
+  // Without targets
+  mutation.reset();
+  REQUIRE(mutation.update(.01, diverse, 0, 0) == .01);
+}
+
+TEST_CASE("Mutation rate of a genetic run") {
+  const coordinate_list ground_line{
+      {0, 100},    {1000, 500}, {1500, 1500}, {3000, 1000},
+      {4000, 150}, {5500, 150}, {6999, 800},
+  };
+  const simulation_data initial{
+      .position = {2500, 2700},
+      .velocity = {0, 0},
+      .fuel = 550,
+      .rotate = 0,
+      .power = 0,
+  };
+  ga_data::generation_parameters params{.mutation_rate = .01};
+
+  const auto rates = [&] {
+    ga_data ga{ground_line, initial};
+    ga.simulate_initial_generation(params);
+    for (int i = 0; i < 30; ++i) {
+      ga.next_generation();
+    }
+    std::vector<double> result;
+    for (const auto &sample : ga.mutation_trace()) {
+      result.push_back(sample.mutation_rate);
+    }
+    return result;
+  };
+
+  auto trace = rates();
+  REQUIRE(trace.size() == 30);
+  REQUIRE(std::ranges::all_of(trace, [](double r) { return r == .01f; }));
+
+  params.adapt_mutation_rate = true;
+  trace = rates();
+  REQUIRE(trace.size() == 30);
+  const auto [lowest, highest] = std::ranges::minmax(trace);
+  // The random first generations mutate less, the converging ones more
+  REQUIRE(lowest < .01f);
+  REQUIRE(highest > lowest);
+  REQUIRE(highest <= .25);
+}
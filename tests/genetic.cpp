@@ -0,0 +1,71 @@
+#include "genetic.hpp"
+#include <catch2/catch_all.hpp>
+
+TEST_CASE("Statistics of a run") {
+  const coordinate_list ground_line{
+      {0, 100},    {1000, 500}, {1500, 1500}, {3000, 1000},
+      {4000, 150}, {5500, 150}, {6999, 800},
+  };
+  const simulation_data initial{
+      .position = {2500, 2700},
+      .velocity = {0, 0},
+      .fuel = 550,
+      .rotate = 0,
+      .power = 0,
+  };
+  ga_data::generation_parameters params{.population_size = 50,
+                                        .screening_stride = 4};
+  ga_data ga{ground_line, initial};
+
+  ga.simulate_initial_generation(params);
+  for (int i = 0; i < 3; ++i) {
+    ga.next_generation();
+  }
+  REQUIRE(ga.stats().screened == 4 * params.population_size);
+
+  // Nothing left from the previous run
+  ga.simulate_initial_generation(params);
+  auto stats = ga.stats();
+  REQUIRE(stats.screened == params.population_size);
+  REQUIRE(stats.promoted <= stats.screened);
+  REQUIRE(stats.reuse_lookups <= params.population_size);
+  REQUIRE(stats.perturbed_time == simulation::duration::zero());
+
+  ga.next_generation();
+  stats = ga.stats();
+  REQUIRE(stats.screened == 2 * params.population_size);
+  REQUIRE(stats.reuse_lookups <= 2 * params.population_size);
+}
+
+TEST_CASE("Transposition table of a run") {
+  const coordinate_list ground_line{
+      {0, 100},    {1000, 500}, {1500, 1500}, {3000, 1000},
+      {4000, 150}, {5500, 150}, {6999, 800},
+  };
+  const simulation_data initial{
+      .position = {2500, 2700},
+      .velocity = {0, 0},
+      .fuel = 550,
+      .rotate = 0,
+      .power = 0,
+  };
+  ga_data::generation_parameters params{.population_size = 50,
+                                        .transposition_memory = 1 << 20};
+  ga_data ga{ground_line, initial};
+  ga.simulate_initial_generation(params);
+  for (int i = 0; i < 20; ++i) {
+    ga.next_generation();
+    // Only the exact simulation can land
+    const auto summaries = ga.current_generation_summaries();
+    for (size_t j = 0; j < summaries.size(); ++j) {
+      if (summaries[j].success()) {
+        REQUIRE(ga.replay(j).final_status == simulation::status::land);
+      }
+    }
+  }
+  const auto table = ga.stats().transpositions;
+  REQUIRE(table.memory > 0);
+  REQUIRE(table.memory <= params.transposition_memory);
+  REQUIRE(table.lookups > 0);
+  REQUIRE(table.hits + table.misses == table.lookups);
+}
@@ -1,6 +1,10 @@
 #include "math.hpp"
 #include <catch2/catch_all.hpp>
 
+#include <memory>
+#include <random>
+#include <vector>
+
 TEST_CASE("Coordinates") {
   struct coordinates {
     float x;
@@ -48,3 +52,62 @@ TEST_CASE("Distance") {
   segment s2{a1,a3};
   REQUIRE(distance_squared_to_segment(s2, coordinates{10, 10}) == 50.f);
 }
+
+TEST_CASE("Batched segment tests") {
+  struct coordinates {
+    float x;
+    float y;
+  };
+  std::mt19937 rng{42};
+  // Small integer coordinates give plenty of shared endpoints, collinear and
+  // parallel segments
+  auto grid = std::uniform_int_distribution<int>(0, 6);
+  auto wide = std::uniform_real_distribution<float>(0.f, 7000.f);
+  const auto random_segment = [&](bool on_grid) {
+    const auto c = [&] {
+      return on_grid ? static_cast<float>(grid(rng)) : wide(rng);
+    };
+    return segment{coordinates{c(), c()}, coordinates{c(), c()}};
+  };
+
+  for (int round = 0; round < 200; ++round) {
+    const bool on_grid = round % 2 == 0;
+    const auto count = static_cast<size_t>(round % 37);
+    std::vector<segment<coordinates>> segments;
+    segment_arrays arrays;
+    for (size_t i = 0; i < count; ++i) {
+      segments.push_back(random_segment(on_grid));
+      arrays.push_back(segments.back());
+    }
+    const auto s = random_segment(on_grid);
+
+    auto crossing = std::make_unique<bool[]>(count);
+    segments_intersect(arrays, s, crossing.get());
+
+    size_t expected_crossing = count;
+    size_t expected_intersection = count;
+    for (size_t i = count; i-- > 0;) {
+      REQUIRE(crossing[i] ==
+              segments_intersect(segments[i], s));
+      if (segments_intersect(segments[i], s)) {
+        expected_crossing = i;
+      }
+      if (intersection(segments[i], s)) {
+        expected_intersection = i;
+      }
+    }
+    REQUIRE(first_crossing(arrays, s) == expected_crossing);
+    REQUIRE(first_intersection(arrays, s) == expected_intersection);
+
+    if (expected_intersection < count) {
+      auto next = expected_intersection + 1;
+      while (next < count && !intersection(segments[next], s)) {
+        ++next;
+      }
+      REQUIRE(first_intersection(arrays, s, expected_intersection + 1) ==
+              next);
+      REQUIRE(first_intersection(arrays, s, 0, expected_intersection) ==
+              expected_intersection);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#include "random.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <future>
+#include <vector>
+
+TEST_CASE("Random numbers") {
+  randf.seed(42);
+  std::vector<double> first(1000);
+  for (auto &value : first) {
+    value = randf();
+    REQUIRE(value >= 0.);
+    REQUIRE(value < 1.);
+  }
+
+  SECTION("Seeding again repeats the numbers") {
+    randf.seed(42);
+    std::vector<double> second(first.size());
+    randf.fill(second);
+    REQUIRE(first == second);
+  }
+
+  SECTION("Other threads get other numbers") {
+    auto other = std::async(std::launch::async, [] {
+                   std::vector<double> values(1000);
+                   randf.fill(values);
+                   return values;
+                 }).get();
+    REQUIRE(other != first);
+  }
+
+  SECTION("Streams") {
+    random_stream a{7, 0};
+    random_stream b{7, 0};
+    random_stream c{7, 1};
+    std::array<int, 10> histogram{};
+    bool differ = false;
+    for (int i = 0; i < 10000; ++i) {
+      auto x = a();
+      REQUIRE(x == b());
+      differ |= x != c();
+      histogram[static_cast<int>(x * histogram.size())]++;
+    }
+    REQUIRE(differ);
+    for (auto count : histogram) {
+      REQUIRE(count == Catch::Approx(1000).margin(100));
+    }
+  }
+}
@@ -0,0 +1,70 @@
+#include "selection.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <vector>
+
+TEST_CASE("Parent selection") {
+  const std::vector<double> scores{1., 2., 3., 4., 0.};
+  constexpr size_t COUNT = 100000;
+
+  const auto frequencies = [](const std::vector<size_t> &parents,
+                              size_t size) {
+    std::vector<double> counts(size, 0.);
+    for (auto parent : parents) {
+      if (parent >= size) {
+        FAIL("Parent out of range: " << parent);
+      }
+      counts[parent]++;
+    }
+    for (auto &c : counts) {
+      c /= parents.size();
+    }
+    return counts;
+  };
+
+  for (auto method : {selection_method::roulette, selection_method::alias,
+                      selection_method::stochastic_universal}) {
+    auto parents = select_parents(method, scores, COUNT);
+    REQUIRE(parents.size() == COUNT);
+    auto f = frequencies(parents, scores.size());
+    for (size_t i = 0; i < scores.size(); ++i) {
+      REQUIRE(f[i] == Catch::Approx(scores[i] / 10.).margin(.01));
+    }
+  }
+
+  SECTION("Stochastic universal sampling stays within one of the expected "
+          "count") {
+    auto parents =
+        select_parents(selection_method::stochastic_universal, scores, 20);
+    auto f = frequencies(parents, scores.size());
+    for (size_t i = 0; i < scores.size(); ++i) {
+      REQUIRE(std::abs(f[i] * 20 - scores[i] * 2) <= 1.);
+    }
+  }
+
+  SECTION("Tournament") {
+    auto f = frequencies(
+        select_parents(selection_method::tournament, scores, COUNT, 3),
+        scores.size());
+    // Best of three: 1 - (4/5)^3 for the best, (1/5)^3 for the worst
+    REQUIRE(f[3] == Catch::Approx(1 - .8 * .8 * .8).margin(.01));
+    REQUIRE(f[4] == Catch::Approx(.2 * .2 * .2).margin(.01));
+  }
+
+  SECTION("No score to tell the individuals apart") {
+    const std::vector<double> zeros(4, 0.);
+    auto f = frequencies(
+        select_parents(selection_method::alias, zeros, COUNT), zeros.size());
+    for (auto frequency : f) {
+      REQUIRE(frequency == Catch::Approx(.25).margin(.01));
+    }
+  }
+}
+
+TEST_CASE("Best indices") {
+  const std::vector<double> scores{3., 1., 4., 1., 5., 9., 2., 6., 5.};
+  REQUIRE(best_indices(scores, 4) == std::vector<size_t>{5, 7, 4, 8});
+  REQUIRE(best_indices(scores, 0).empty());
+  REQUIRE(best_indices(scores, 20).size() == scores.size());
+  REQUIRE(best_indices(scores, 20).back() == 3);
+}
@@ -0,0 +1,585 @@
+#include "acceleration_table.hpp"
+#include "checkpoint_cache.hpp"
+#include "individual.hpp"
+#include "scalar_policy.hpp"
+#include "scenario_engine.hpp"
+#include "simulation.hpp"
+#include "terrain.hpp"
+#include "transposition_table.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace {
+const coordinate_list ground_line{
+    {0, 100},     {1000, 500}, {1500, 1500}, {3000, 1000},
+    {4000, 150},  {5500, 150}, {6999, 800},
+};
+const simulation_data initial{
+    .position = {2500, 2700},
+    .velocity = {0, 0},
+    .fuel = 550,
+    .rotate = 0,
+    .power = 0,
+};
+const segment<coordinates> landing_site{{4000, 150}, {5500, 150}};
+} // namespace
+
+TEST_CASE("Batch simulation matches individual simulations") {
+  terrain ground{ground_line};
+  simulation::input_data input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  const auto individuals = random_generation(50, initial, landing_site);
+  const auto gen = individuals.views();
+
+  auto batch = simulation::simulate_batch(input, std::span{std::as_const(gen)});
+  REQUIRE(batch.size() == gen.size());
+
+  const auto same_data = [](const simulation_data &a,
+                             const simulation_data &b) {
+    return a.position == b.position && a.velocity == b.velocity &&
+           a.fuel == b.fuel && a.rotate == b.rotate && a.power == b.power;
+  };
+
+  for (size_t i = 0; i < gen.size(); ++i) {
+    auto full = simulation::simulate(input, gen[i]);
+    simulation::summary expected{full};
+    const auto &actual = batch[i];
+    REQUIRE(actual.final_status == expected.final_status);
+    REQUIRE(actual.reason == expected.reason);
+    REQUIRE(actual.ticks == expected.ticks);
+    REQUIRE(static_cast<size_t>(actual.ticks) == full.decisions.size());
+    REQUIRE(same_data(actual.last, expected.last));
+    REQUIRE(same_data(actual.before_last, expected.before_last));
+  }
+}
+
+TEST_CASE("Terrain lookup") {
+  terrain ground{ground_line};
+  REQUIRE(ground.landing_site() == landing_site);
+  REQUIRE(ground.max_height() == 1500);
+  REQUIRE(ground.segment_count() == ground_line.size() - 1);
+
+  const auto touched = [&](coordinates start, coordinates end) {
+    std::vector<size_t> found;
+    ground.find_intersection({start, end}, [&](size_t i) {
+      found.push_back(i);
+      return false;
+    });
+    return found;
+  };
+
+  // Above everything
+  REQUIRE(touched({2500, 1700}, {2510, 1600}).empty());
+  // Above the landing site, below the peak
+  REQUIRE(touched({4500, 300}, {4510, 200}).empty());
+  REQUIRE(touched({4500, 200}, {4510, 100}) == std::vector<size_t>{4});
+  // Ending on the ground counts
+  REQUIRE(touched({4500, 200}, {4500, 150}) == std::vector<size_t>{4});
+  // Through the peak, segments come in ground line order
+  REQUIRE(touched({1400, 1400}, {1900, 1400}) == std::vector<size_t>{1, 2});
+  // Across most of the buckets
+  REQUIRE(touched({10, 50}, {6990, 50}).empty());
+  REQUIRE(touched({10, 120}, {6990, 120}) == std::vector<size_t>{0});
+}
+
+TEST_CASE("Acceleration table") {
+  static_assert(ACCELERATION.y[acceleration_table::index(0, 0)] ==
+                -MARS_GRAVITY);
+  for (int rotate = -MAX_ROTATION; rotate <= MAX_ROTATION; ++rotate) {
+    for (int power = 0; power <= MAX_POWER; ++power) {
+      auto i = acceleration_table::index(rotate, power);
+      REQUIRE(ACCELERATION.x[i] ==
+              Catch::Approx(power * (-std::sin(rotate * DEG_TO_RAD)))
+                  .margin(1e-12));
+      REQUIRE(ACCELERATION.y[i] ==
+              Catch::Approx(power * (std::cos(rotate * DEG_TO_RAD)) -
+                            MARS_GRAVITY)
+                  .margin(1e-12));
+    }
+  }
+}
+
+TEST_CASE("Resuming from a checkpoint matches a full simulation") {
+  terrain ground{ground_line};
+  simulation::input_data input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  const auto individuals = random_generation(20, initial, landing_site);
+  const auto gen = individuals.views();
+  const std::span processes{std::as_const(gen)};
+
+  auto expected = simulation::simulate_batch(input, processes);
+
+  std::vector<simulation::summary> checkpoints(gen.size(),
+                                               simulation::summary{initial});
+  std::vector<simulation::summary> states(gen.size(),
+                                          simulation::summary{initial});
+  simulation::resume_batch(input, processes, std::span{states}, 10,
+                           [&](size_t i, const simulation::summary &s) {
+                             REQUIRE(s.ticks % 10 == 0);
+                             if (s.ticks == 10) {
+                               checkpoints[i] = s;
+                             }
+                           });
+  simulation::resume_batch(input, processes, std::span{checkpoints}, 0,
+                           [](size_t, const simulation::summary &) {});
+
+  for (size_t i = 0; i < gen.size(); ++i) {
+    REQUIRE(states[i].ticks == expected[i].ticks);
+    REQUIRE(checkpoints[i].ticks == expected[i].ticks);
+    REQUIRE(checkpoints[i].final_status == expected[i].final_status);
+    REQUIRE(checkpoints[i].last.position == expected[i].last.position);
+    REQUIRE(checkpoints[i].last.velocity == expected[i].last.velocity);
+    REQUIRE(checkpoints[i].last.fuel == expected[i].last.fuel);
+  }
+}
+
+TEST_CASE("Coasting matches stepping tick by tick") {
+  terrain ground{ground_line};
+  simulation::input_data input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+
+  // Same decisions, without the hold() shortcut
+  struct stepped {
+    individual_view ind;
+    decision operator()(const simulation_data &data,
+                        const std::vector<coordinates> &ground_line,
+                        int current_frame) const {
+      return ind(data, ground_line, current_frame);
+    }
+  };
+  static_assert(!HoldingDecisionProcess<stepped>);
+
+  const auto individuals = random_generation(50, initial, landing_site);
+
+  const auto gen = individuals.views();
+  int coasting = 0;
+  for (const auto &ind : gen) {
+    auto expected = simulation::simulate(input, stepped{ind});
+    auto actual = simulation::simulate(input, ind);
+    REQUIRE(actual.final_status == expected.final_status);
+    REQUIRE(actual.reason == expected.reason);
+    REQUIRE(actual.history.size() == expected.history.size());
+    for (size_t t = 0; t < expected.history.size(); ++t) {
+      REQUIRE(actual.history[t].position == expected.history[t].position);
+      REQUIRE(actual.history[t].velocity == expected.history[t].velocity);
+      REQUIRE(actual.history[t].fuel == expected.history[t].fuel);
+    }
+    REQUIRE(actual.decisions.size() == expected.decisions.size());
+    for (size_t t = 0; t < expected.decisions.size(); ++t) {
+      REQUIRE(actual.decisions[t].rotate == expected.decisions[t].rotate);
+      REQUIRE(actual.decisions[t].power == expected.decisions[t].power);
+    }
+    if (simulation::coasting_ticks(ind, initial, input, 0) > 0) {
+      coasting++;
+    }
+  }
+  // The fixed value individuals at the start of a random generation coast
+  REQUIRE(coasting > 0);
+}
+
+TEST_CASE("Control points") {
+  terrain ground{ground_line};
+  simulation::input_data input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  constexpr unsigned int SPACING = 4;
+  const auto coarse = random_generation(30, initial, landing_site,
+                                        genes_for(120, SPACING), SPACING);
+  REQUIRE(coarse.spacing() == SPACING);
+  REQUIRE(coarse.ticks() >= 120);
+
+  SECTION("Interpolation") {
+    const auto ind = coarse[10];
+    REQUIRE(ind.at(0) == ind.genes[0]);
+    REQUIRE(ind.at(SPACING) == ind.genes[1]);
+    const auto a = ind.genes[0].rotate;
+    const auto b = ind.genes[1].rotate;
+    REQUIRE(ind.at(SPACING / 2).rotate == (a + b) / 2);
+    REQUIRE(ind.at(ind.size * SPACING) == gene::NEUTRAL);
+    // Same genes, other spacing
+    auto per_tick = individual{ind};
+    per_tick.spacing = 1;
+    REQUIRE(per_tick.hash() != ind.hash());
+    // Trailing neutral genes, as a longer horizon adds, fly the same
+    auto longer = individual{ind};
+    longer.genes.resize(ind.size + 5, gene::NEUTRAL);
+    REQUIRE(longer.hash() == ind.hash());
+    const auto expected = simulation::simulate(input, ind);
+    const auto actual = simulation::simulate(input, longer);
+    REQUIRE(actual.final_status == expected.final_status);
+    REQUIRE(actual.history.size() == expected.history.size());
+    REQUIRE(actual.history.back().position ==
+            expected.history.back().position);
+  }
+
+  SECTION("Refining keeps the commands") {
+    generation finer;
+    respace(coarse, finer, SPACING / 2);
+    REQUIRE(finer.ticks() >= coarse.ticks());
+    for (size_t i = 0; i < coarse.size(); ++i) {
+      for (size_t frame = 0; frame < coarse.ticks(); ++frame) {
+        const auto before = coarse[i].at(frame);
+        const auto after = finer[i].at(frame);
+        // Rounded down twice
+        REQUIRE(std::abs(before.rotate - after.rotate) <= 1);
+        REQUIRE(std::abs(before.power - after.power) <= 1);
+      }
+    }
+
+    // One gene per tick takes the interpolated commands as they are
+    generation per_tick;
+    respace(coarse, per_tick, 1);
+    for (size_t i = 0; i < coarse.size(); ++i) {
+      auto expected = simulation::simulate(input, coarse[i]);
+      auto actual = simulation::simulate(input, per_tick[i]);
+      REQUIRE(actual.final_status == expected.final_status);
+      REQUIRE(actual.history.size() == expected.history.size());
+      REQUIRE(actual.history.back().position ==
+              expected.history.back().position);
+    }
+
+    // Same commands, same checkpoints
+    checkpoint_cache cache{3};
+    std::vector<checkpoint_cache::key> keys(cache.depth(coarse.ticks()));
+    std::vector<checkpoint_cache::key> same(keys.size());
+    for (size_t i = 0; i < coarse.size(); ++i) {
+      cache.keys(coarse[i], keys);
+      cache.keys(per_tick[i], same);
+      REQUIRE(keys == same);
+    }
+  }
+
+  SECTION("Genes rounding to the same commands") {
+    const auto per_tick = random_generation(30, initial, landing_site, 120);
+    checkpoint_cache cache{3};
+    std::vector<checkpoint_cache::key> keys(cache.depth(per_tick.ticks()));
+    std::vector<checkpoint_cache::key> same(keys.size());
+    size_t nudged_genes = 0;
+    for (size_t i = 0; i < per_tick.size(); ++i) {
+      individual nudged{per_tick[i]};
+      for (auto &g : nudged.genes) {
+        const gene other{static_cast<std::uint16_t>(g.rotate ^ 1),
+                         static_cast<std::uint16_t>(g.power ^ 1)};
+        if (other.rotation_change() == g.rotation_change() &&
+            other.power_change() == g.power_change()) {
+          g = other;
+          nudged_genes++;
+        }
+      }
+      cache.keys(per_tick[i], keys);
+      cache.keys(nudged.view(), same);
+      REQUIRE(keys == same);
+      const auto expected = simulation::simulate(input, per_tick[i]);
+      const auto actual = simulation::simulate(input, nudged);
+      REQUIRE(actual.final_status == expected.final_status);
+      REQUIRE(actual.history.size() == expected.history.size());
+      REQUIRE(actual.history.back().position ==
+              expected.history.back().position);
+    }
+    REQUIRE(nudged_genes > 0);
+  }
+
+  SECTION("Batches and checkpoints") {
+    const auto gen = coarse.views();
+    const std::span processes{std::as_const(gen)};
+    auto expected = simulation::simulate_batch(input, processes);
+    for (size_t i = 0; i < gen.size(); ++i) {
+      REQUIRE(expected[i].ticks ==
+              simulation::summary{simulation::simulate(input, gen[i])}.ticks);
+    }
+
+    checkpoint_cache cache{3};
+    std::vector<checkpoint_cache::key> keys(cache.depth(coarse.ticks()));
+    std::vector<checkpoint_cache::key> other(keys.size());
+    cache.keys(gen[8], keys);
+    cache.keys(gen[9], other);
+    REQUIRE(keys[0] != other[0]);
+    // Ticks 6 and 9 are decided by the same control points, the ticks in
+    // between still tell the checkpoints apart
+    REQUIRE(keys[1] != keys[2]);
+    REQUIRE(cache.find(keys) == nullptr);
+    cache.insert(keys[2], simulation::summary{initial});
+    REQUIRE(cache.find(keys) == nullptr);
+    cache.insert(keys[0], simulation::summary{initial});
+    cache.insert(keys[1], simulation::summary{initial});
+    REQUIRE(cache.find(keys) != nullptr);
+    REQUIRE(cache.find(other) == nullptr);
+  }
+}
+
+TEST_CASE("Commands are held past the last gene") {
+  terrain ground{ground_line};
+  simulation::input_data input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  const auto individuals = random_generation(30, initial, landing_site, 18);
+  REQUIRE(individuals.length() == 18);
+
+  for (size_t i = 0; i < individuals.size(); ++i) {
+    const auto short_genome = individuals[i];
+    individual extended{landing_site, 600};
+    std::ranges::copy(short_genome.genome(), extended.genes.begin());
+
+    auto expected = simulation::simulate(input, extended);
+    auto actual = simulation::simulate(input, short_genome);
+    // Flights outlast the genes
+    REQUIRE(actual.decisions.size() > short_genome.size);
+    REQUIRE(actual.final_status == expected.final_status);
+    REQUIRE(actual.history.size() == expected.history.size());
+    REQUIRE(actual.history.back().position == expected.history.back().position);
+    REQUIRE(actual.history.back().fuel == expected.history.back().fuel);
+  }
+}
+
+TEST_CASE("Doomed landers never land") {
+  terrain ground{ground_line};
+  REQUIRE(ground.min_height() == 100);
+  simulation::input_data full_input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  simulation::input_data input{.ground = ground,
+                               .coords = ground_line,
+                               .initial_data = initial,
+                               .doomed_check_interval = 5};
+  const auto individuals = random_generation(100, initial, landing_site);
+  const auto gen = individuals.views();
+
+  auto batch = simulation::simulate_batch(input, std::span{std::as_const(gen)});
+  size_t doomed = 0;
+  for (size_t i = 0; i < gen.size(); ++i) {
+    auto cut = simulation::simulate(input, gen[i]);
+    REQUIRE(batch[i].final_status == cut.final_status);
+    REQUIRE(static_cast<size_t>(batch[i].ticks) == cut.decisions.size());
+
+    auto full = simulation::simulate(full_input, gen[i]);
+    if (cut.final_status == simulation::status::doomed) {
+      doomed++;
+      // Caught on a check, coasting or not, and left where it was
+      REQUIRE(cut.decisions.size() % 5 == 0);
+      REQUIRE(cut.history.back().position ==
+              full.history[cut.history.size() - 1].position);
+      REQUIRE(full.final_status != simulation::status::land);
+    } else {
+      REQUIRE(cut.final_status == full.final_status);
+      REQUIRE(cut.history.size() == full.history.size());
+    }
+  }
+  REQUIRE(doomed > 0);
+
+  // Falling too fast that close to the ground
+  auto falling = initial;
+  falling.position.y = 300;
+  falling.velocity.y = -60;
+  REQUIRE(simulation::doomed(falling, input));
+  REQUIRE_FALSE(simulation::doomed(initial, input));
+}
+
+TEST_CASE("Transposition table") {
+  REQUIRE_FALSE(transposition_table{}.find(1, simulation::summary{}));
+
+  transposition_table table{1 << 16};
+  REQUIRE(table.enabled());
+  REQUIRE(table.memory() <= 1 << 16);
+
+  auto nearby = initial;
+  nearby.position.x += .2f;
+  const auto key = transposition_table::make_key(initial, 10);
+  REQUIRE(transposition_table::make_key(nearby, 10) == key);
+  REQUIRE(transposition_table::make_key(initial, 11) != key);
+
+  simulation::summary from{initial};
+  from.ticks = 10;
+  simulation::summary outcome{initial};
+  outcome.ticks = 50;
+  outcome.final_status = simulation::status::crash;
+  table.insert(key, from.ticks, {.outcome = outcome, .commands = 42});
+
+  // Outcomes are relative to the state they were recorded from
+  from.ticks = 20;
+  auto found = table.find(key, from);
+  REQUIRE(found);
+  REQUIRE(found->commands == 42);
+  REQUIRE(found->outcome.ticks == 60);
+  REQUIRE(found->outcome.final_status == simulation::status::crash);
+  REQUIRE_FALSE(table.find(key + 2, from));
+
+  // Only dead ends, an approximate landing is never handed out
+  const auto landing_key = transposition_table::make_key(initial, 12);
+  outcome.final_status = simulation::status::land;
+  table.insert(landing_key, 0, {.outcome = outcome, .commands = 42});
+  REQUIRE_FALSE(table.find(landing_key, from));
+
+  auto stats = table.stats();
+  REQUIRE(stats.lookups == 3);
+  REQUIRE(stats.hits == 0);
+  table.count_hit();
+  stats = table.stats();
+  REQUIRE(stats.hits == 1);
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.inserts == 1);
+  REQUIRE(stats.memory == table.memory());
+
+  SECTION("Concurrent readers never see a torn entry") {
+    std::atomic<bool> torn{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&, t] {
+        simulation::summary start{initial};
+        for (int i = 0; i < 20000; ++i) {
+          simulation::summary value{initial};
+          value.ticks = t * 20000 + i;
+          value.last.fuel = value.ticks;
+          value.final_status = simulation::status::doomed;
+          table.insert(key, 0,
+                       {.outcome = value,
+                        .commands = static_cast<std::uint64_t>(value.ticks)});
+          if (auto e = table.find(key, start);
+              e &&
+              (e->commands != static_cast<std::uint64_t>(e->outcome.ticks) ||
+               e->outcome.last.fuel != e->outcome.ticks)) {
+            torn = true;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    REQUIRE_FALSE(torn);
+  }
+}
+
+TEST_CASE("Scalar policies") {
+  terrain ground{ground_line};
+  simulation::input_data input{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  const auto individuals = random_generation(20, initial, landing_site);
+  const auto gen = individuals.views();
+
+  SECTION("Mixed precision is what simulation computes") {
+    using k = kinematics<mixed_precision>;
+    for (const auto &ind : gen) {
+      const auto full = simulation::simulate(input, ind);
+      auto state = k::from(full.history.front());
+      // The last position is moved to the point of impact
+      for (size_t i = 1; i + 1 < full.history.size(); ++i) {
+        const auto &expected = full.history[i];
+        state = k::step(state, expected.rotate, expected.power);
+        REQUIRE(state.x == expected.position.x);
+        REQUIRE(state.y == expected.position.y);
+        REQUIRE(state.vx == expected.velocity.x);
+        REQUIRE(state.vy == expected.velocity.y);
+        REQUIRE(state.fuel == expected.fuel);
+      }
+    }
+  }
+
+  SECTION("Both engines agree under every policy") {
+    const std::span processes{std::as_const(gen)};
+    const auto mixed = simulation::simulate_batch(input, processes);
+    size_t differing = 0;
+    const auto check = [&]<class Policy>() {
+      const auto batch = simulation::simulate_batch<Policy>(input, processes);
+      for (size_t i = 0; i < gen.size(); ++i) {
+        const simulation::summary expected{
+            simulation::simulate<Policy>(input, gen[i])};
+        REQUIRE(batch[i].final_status == expected.final_status);
+        REQUIRE(batch[i].ticks == expected.ticks);
+        REQUIRE(batch[i].last.position == expected.last.position);
+        REQUIRE(batch[i].last.velocity == expected.last.velocity);
+        REQUIRE(batch[i].last.fuel == expected.last.fuel);
+        differing += !(batch[i].last.position == mixed[i].last.position);
+      }
+    };
+    check.operator()<mixed_precision>();
+    REQUIRE(differing == 0);
+    check.operator()<double_precision>();
+    check.operator()<single_precision>();
+    check.operator()<fixed_precision>();
+    // The policies are what the engines compute with
+    REQUIRE(differing > 0);
+  }
+
+  SECTION("Fixed point") {
+    REQUIRE(fixed_point(1.5) + fixed_point(2.25) == fixed_point(3.75));
+    REQUIRE(static_cast<double>(fixed_point(-3.711)) ==
+            Catch::Approx(-3.711).margin(1. / fixed_point::ONE));
+    REQUIRE(fixed_point(.1) - fixed_point(.1) == fixed_point{});
+  }
+
+  SECTION("Divergence report") {
+    const auto full = simulation::simulate(input, gen.front());
+    const auto report = compare_precisions(full.history);
+    REQUIRE(report.size() == 3);
+    for (const auto &d : report) {
+      REQUIRE(d.max_position_error < 10.);
+      REQUIRE(d.max_velocity_error < 1.);
+    }
+  }
+}
+
+namespace {
+constexpr scenario<7> test_scenario{
+    .name = "test",
+    .initial = initial,
+    .ground_line = {{
+        {0, 100},
+        {1000, 500},
+        {1500, 1500},
+        {3000, 1000},
+        {4000, 150},
+        {5500, 150},
+        {6999, 800},
+    }},
+};
+} // namespace
+
+TEST_CASE("Scenario specialization matches the generic simulation") {
+  terrain ground{ground_line};
+  simulation::input_data generic{
+      .ground = ground, .coords = ground_line, .initial_data = initial};
+  simulation::input_data specialized{
+      .ground = ground,
+      .coords = ground_line,
+      .initial_data = initial,
+      .specialized_touchdown = &scenario_engine<test_scenario>::touchdown};
+  REQUIRE(std::ranges::equal(test_scenario.ground_line, ground_line));
+  REQUIRE(scenario_engine<test_scenario>::CUTOFF == ground.max_height());
+
+  SECTION("Collisions") {
+    std::mt19937 rng{7};
+    auto x = std::uniform_real_distribution<float>(0, 7000);
+    auto y = std::uniform_real_distribution<float>(0, 1600);
+    auto speed = std::uniform_real_distribution<float>(-150, 150);
+    for (int i = 0; i < 10000; ++i) {
+      const coordinates start{x(rng), y(rng)};
+      simulation_data expected{
+          .position = {start.x + speed(rng), start.y + speed(rng)},
+          .velocity = {speed(rng) / 5, speed(rng) / 5},
+          .fuel = 100,
+          .rotate = i % 3 == 0 ? 0 : 15,
+          .power = 4,
+      };
+      auto actual = expected;
+      auto expected_result = simulation::touchdown(generic, start, expected);
+      auto actual_result = simulation::touchdown(specialized, start, actual);
+      REQUIRE(actual_result == expected_result);
+      REQUIRE(actual.position == expected.position);
+    }
+  }
+
+  SECTION("Batches") {
+    const auto individuals = random_generation(50, initial, landing_site);
+    const auto gen = individuals.views();
+    auto expected =
+        simulation::simulate_batch(generic, std::span{std::as_const(gen)});
+    auto actual =
+        simulation::simulate_batch(specialized, std::span{std::as_const(gen)});
+    for (size_t i = 0; i < gen.size(); ++i) {
+      REQUIRE(actual[i].final_status == expected[i].final_status);
+      REQUIRE(actual[i].reason == expected[i].reason);
+      REQUIRE(actual[i].ticks == expected[i].ticks);
+      REQUIRE(actual[i].last.position == expected[i].last.position);
+    }
+  }
+}